@@ -0,0 +1,352 @@
+/*
+Copyright (C) 2019  Anthony Arrowood
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "autosave.h"
+#include "xlsxzipreader_p.h"
+#include "xlsxcellrange.h"
+#include "xlsxcellreference.h"
+
+#include <QBuffer>
+#include <QDateTime>
+#include <QDebug>
+#include <QtNumeric>
+
+static const char sheetPath[] = "xl/worksheets/sheet1.xml";
+static const int chunkCells = 1 << 20;  // cells read from the document per append
+
+/**
+ * Updates the zip (IEEE 802.3) checksum \a crc with \a data.
+ * Checksums can be chained, crc32(crc32(0, a), b) == crc32(0, a + b).
+ */
+static quint32 crc32(quint32 crc, const QByteArray &data)
+{
+    // built on first use, thread safe so that several Autosaves can run in parallel
+    static const QVector<quint32> table = [] {
+        QVector<quint32> t(256);
+        for (quint32 i = 0; i < 256; i++) {
+            quint32 c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (char ch : data)
+        crc = table[(crc ^ static_cast<quint8>(ch)) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void put16(QByteArray &ba, quint16 v)
+{
+    ba.append(static_cast<char>(v & 0xFF));
+    ba.append(static_cast<char>(v >> 8));
+}
+
+static void put32(QByteArray &ba, quint32 v)
+{
+    put16(ba, static_cast<quint16>(v & 0xFFFF));
+    put16(ba, static_cast<quint16>(v >> 16));
+}
+
+
+Autosave::Autosave(QXlsx::Document *doc, QObject *parent)
+    : QObject(parent), doc(doc), sheetCrc(0), sheetSize(0), appendPos(0), savedRows(0), dosTime(0), dosDate(0)
+{
+    connect(&timer, &QTimer::timeout, this, &Autosave::save);
+}
+
+Autosave::~Autosave()
+{
+    stop();
+}
+
+/**
+ * Writes the current contents of the document to \a fileName and
+ * appends new rows to it every \a intervalMs milliseconds.
+ * With an interval of 0 rows are only appended by explicit calls to save() or appendRows().
+ */
+bool Autosave::start(const QString &fileName, int intervalMs)
+{
+    stop();
+
+    // let QXlsx build the package once and keep its parts
+    QBuffer package;
+    package.open(QIODevice::WriteOnly);
+    if (!doc->saveAs(&package)) {
+        qDebug() << " Autosave failed to build the workbook \n";
+        return false;
+    }
+    package.close();
+    package.open(QIODevice::ReadOnly);
+    QXlsx::ZipReader reader(&package);
+
+    QByteArray sheet = reader.fileData(QLatin1String(sheetPath));
+    // the dimension is optional and would be stale after the first append
+    int dimBegin = sheet.indexOf("<dimension ");
+    if (dimBegin != -1)
+        sheet.remove(dimBegin, sheet.indexOf("/>", dimBegin) + 2 - dimBegin);
+
+    QByteArray sheetPrefix;
+    int dataEnd = sheet.indexOf("</sheetData>");
+    if (dataEnd != -1) {
+        sheetPrefix = sheet.left(dataEnd);
+        this->sheetSuffix = sheet.mid(dataEnd);
+    } else {
+        dataEnd = sheet.indexOf("<sheetData/>");
+        if (dataEnd == -1) {
+            qDebug() << " Autosave could not find the sheet data \n";
+            return false;
+        }
+        sheetPrefix = sheet.left(dataEnd) + "<sheetData>";
+        this->sheetSuffix = "</sheetData>" + sheet.mid(dataEnd + 12);
+    }
+
+    this->file.setFileName(fileName);
+    // unbuffered, so that each tail goes to the file in one piece, see writeSheetTail()
+    if (!this->file.open(QIODevice::ReadWrite | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        qDebug() << " Autosave failed to open " << fileName << " : " << this->file.errorString() << "\n";
+        return false;
+    }
+
+    QDateTime now = QDateTime::currentDateTime();
+    this->dosTime = static_cast<quint16>((now.time().hour() << 11) | (now.time().minute() << 5) | (now.time().second() / 2));
+    this->dosDate = static_cast<quint16>(((now.date().year() - 1980) << 9) | (now.date().month() << 5) | now.date().day());
+
+    // the static parts are written once and never touched again
+    bool ok = true;
+    for (const QString &path : reader.filePaths()) {
+        if (path == QLatin1String(sheetPath))
+            continue;
+        QByteArray data = reader.fileData(path);
+        Entry entry = { path.toUtf8(), crc32(0, data), static_cast<quint32>(data.size()), static_cast<quint32>(this->file.pos()) };
+        ok = ok && writeAt(entry.offset, localHeader(entry) + data);
+        this->entries.append(entry);
+    }
+
+    Entry sheetEntry = { QByteArray(sheetPath), 0, 0, static_cast<quint32>(this->file.pos()) };
+    ok = ok && writeAt(sheetEntry.offset, localHeader(sheetEntry) + sheetPrefix);  // header patched in writeSheetTail()
+    this->entries.append(sheetEntry);
+    this->sheetCrc = crc32(0, sheetPrefix);
+    this->sheetSize = static_cast<quint32>(sheetPrefix.size());
+    this->appendPos = this->file.pos();
+
+    QXlsx::CellRange dim = doc->dimension();
+    this->savedRows = dim.isValid() ? dim.lastRow() : 0;
+
+    if (!ok || !writeSheetTail(QByteArray())) {
+        qDebug() << " Autosave failed to write " << fileName << " : " << this->file.errorString() << "\n";
+        this->file.close();
+        this->entries.clear();
+        return false;
+    }
+
+    setInterval(intervalMs);
+    if (intervalMs > 0)
+        this->timer.start();
+    return true;
+}
+
+/**
+ * Saves any pending rows and closes the file.
+ */
+void Autosave::stop()
+{
+    if (!isActive())
+        return;
+    this->timer.stop();
+    save();
+    this->file.close();
+    this->entries.clear();
+}
+
+bool Autosave::isActive() const
+{
+    return this->file.isOpen();
+}
+
+void Autosave::setInterval(int intervalMs)
+{
+    this->timer.setInterval(intervalMs);
+}
+
+/**
+ * Appends the rows added to the document since the last save.
+ * Called by the timer, may also be called directly to force a save.
+ */
+bool Autosave::save()
+{
+    if (!isActive())
+        return false;
+
+    QXlsx::CellRange dim = doc->dimension();
+    if (!dim.isValid() || dim.lastRow() <= this->savedRows)
+        return true;
+
+    // read the new rows in chunks, the buffer of a single read could exceed what an int can count
+    const int columnCount = dim.lastColumn();
+    const int chunkRows = qMax(1, chunkCells / columnCount);
+    QVector<double> values;
+    while (this->savedRows < dim.lastRow()) {
+        const int rowCount = qMin(chunkRows, dim.lastRow() - this->savedRows);
+        values.resize(rowCount * columnCount);
+        doc->readRange(QXlsx::CellRange(this->savedRows + 1, 1, this->savedRows + rowCount, columnCount), values.data());
+        if (!appendRows(rowCount, columnCount, values.constData()))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Appends \a rowCount rows of \a columnCount numbers each, stored row by row in \a values,
+ * after the last saved row. NaN values are left empty.
+ * The rows do not have to be in the document, which lets a caller stream any number of rows
+ * into the file with bounded memory.
+ */
+bool Autosave::appendRows(int rowCount, int columnCount, const double *values)
+{
+    if (!isActive())
+        return false;
+
+    QByteArray rows;
+    const double *value = values;
+    const int lastRow = this->savedRows + rowCount;
+    for (int row = this->savedRows + 1; row <= lastRow; row++) {
+        rows += "<row r=\"" + QByteArray::number(row) + "\">";
+        for (int col = 1; col <= columnCount; col++, value++) {
+            if (qIsNaN(*value))
+                continue;
+            rows += "<c r=\"" + QXlsx::CellReference(row, col).toString().toLatin1() + "\"><v>"
+                    + QByteArray::number(*value, 'g', 15) + "</v></c>";
+        }
+        rows += "</row>";
+    }
+
+    if (!writeSheetTail(rows))
+        return false;
+    this->savedRows = lastRow;
+    return true;
+}
+
+QByteArray Autosave::localHeader(const Entry &entry) const
+{
+    QByteArray header;
+    put32(header, 0x04034b50);
+    put16(header, 20);  // version needed to extract
+    put16(header, 0);   // flags
+    put16(header, 0);   // stored, no compression
+    put16(header, this->dosTime);
+    put16(header, this->dosDate);
+    put32(header, entry.crc);
+    put32(header, entry.size);  // compressed size
+    put32(header, entry.size);  // uncompressed size
+    put16(header, static_cast<quint16>(entry.name.size()));
+    put16(header, 0);   // extra field length
+    header.append(entry.name);
+    return header;
+}
+
+bool Autosave::writeAt(qint64 pos, const QByteArray &data)
+{
+    return this->file.seek(pos) && this->file.write(data) == data.size();
+}
+
+/**
+ * Returns \a rows followed by the end of the worksheet and the central directory,
+ * with \a sheetEntry in place of the worksheet entry.
+ */
+QByteArray Autosave::sheetTail(const QByteArray &rows, const Entry &sheetEntry) const
+{
+    QByteArray tail = rows + this->sheetSuffix;
+    const quint32 directoryOffset = static_cast<quint32>(this->appendPos + tail.size());
+    int directoryBegin = tail.size();
+    for (int i = 0; i < this->entries.size(); i++) {
+        const Entry &entry = i == this->entries.size() - 1 ? sheetEntry : this->entries[i];
+        put32(tail, 0x02014b50);
+        put16(tail, 20);    // version made by
+        put16(tail, 20);    // version needed to extract
+        put16(tail, 0);     // flags
+        put16(tail, 0);     // stored, no compression
+        put16(tail, this->dosTime);
+        put16(tail, this->dosDate);
+        put32(tail, entry.crc);
+        put32(tail, entry.size);
+        put32(tail, entry.size);
+        put16(tail, static_cast<quint16>(entry.name.size()));
+        put16(tail, 0);     // extra field length
+        put16(tail, 0);     // comment length
+        put16(tail, 0);     // disk number
+        put16(tail, 0);     // internal attributes
+        put32(tail, 0);     // external attributes
+        put32(tail, entry.offset);
+        tail.append(entry.name);
+    }
+    const quint32 directorySize = static_cast<quint32>(tail.size() - directoryBegin);
+    put32(tail, 0x06054b50);
+    put16(tail, 0);
+    put16(tail, 0);
+    put16(tail, static_cast<quint16>(this->entries.size()));
+    put16(tail, static_cast<quint16>(this->entries.size()));
+    put32(tail, directorySize);
+    put32(tail, directoryOffset);
+    put16(tail, 0);     // comment length
+    return tail;
+}
+
+/**
+ * Appends \a rows to the worksheet, followed by the end of the worksheet and the central
+ * directory, then patches the worksheet's local header with its new size and checksum.
+ *
+ * The rows overwrite the previous tail, so they are written together with the new tail in a single
+ * write of the unbuffered file. The file therefore always ends in a central directory that matches
+ * either the previous or the new rows. The local header is patched last, zip readers take sizes
+ * and checksums from the central directory.
+ *
+ * If a write fails, the previous tail is put back and nothing is changed, so the rows can be
+ * appended again by the next save.
+ */
+bool Autosave::writeSheetTail(const QByteArray &rows)
+{
+    const quint32 crc = crc32(this->sheetCrc, rows);
+    const quint32 size = this->sheetSize + static_cast<quint32>(rows.size());
+    Entry sheetEntry = this->entries.last();
+    sheetEntry.crc = crc32(crc, this->sheetSuffix);
+    sheetEntry.size = size + static_cast<quint32>(this->sheetSuffix.size());
+
+    const QByteArray tail = sheetTail(rows, sheetEntry);
+    bool ok = writeAt(this->appendPos, tail);
+    ok = ok && this->file.resize(this->appendPos + tail.size());
+    ok = ok && writeAt(sheetEntry.offset, localHeader(sheetEntry));
+    ok = ok && this->file.flush();
+    if (!ok) {
+        qDebug() << " Autosave failed to write " << this->file.fileName() << " : " << this->file.errorString() << "\n";
+        const Entry &savedEntry = this->entries.last();
+        const QByteArray savedTail = sheetTail(QByteArray(), savedEntry);
+        if (writeAt(this->appendPos, savedTail) && this->file.resize(this->appendPos + savedTail.size()))
+            writeAt(savedEntry.offset, localHeader(savedEntry));
+        this->file.flush();
+        return false;
+    }
+
+    this->entries.last() = sheetEntry;
+    this->sheetCrc = crc;
+    this->sheetSize = size;
+    this->appendPos += rows.size();
+    return true;
+}
@@ -0,0 +1,88 @@
+/*
+Copyright (C) 2019  Anthony Arrowood
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QVector>
+#include <QByteArray>
+
+#include "xlsxdocument.h"
+
+
+/**
+ * Periodically writes the session workbook to disk without rewriting the whole package.
+ *
+ * When started, the static parts of the package (content types, styles, theme, workbook, ...)
+ * are taken from the document and written once as uncompressed zip entries. The first worksheet
+ * is written last, followed by the central directory. Every save only appends the rows added to
+ * the document since the previous save to the worksheet entry, then rewrites the end of the
+ * worksheet, the central directory and the worksheet's local header.
+ * So the cost of a save is proportional to the number of new rows.
+ * The file is a valid package between saves, and a crash during a save leaves the rows of the
+ * previous or of the new save readable.
+ *
+ * Only numeric cells of the new rows are written, rows that were already saved are never revisited.
+ */
+class Autosave : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Autosave(QXlsx::Document *doc, QObject *parent = nullptr);
+    ~Autosave() override;
+    bool start(const QString &fileName, int intervalMs);
+    void stop();
+    bool isActive() const;
+    void setInterval(int intervalMs);
+    bool appendRows(int rowCount, int columnCount, const double *values);
+
+public slots:
+    bool save();
+
+private:
+    struct Entry
+    {
+        QByteArray name;
+        quint32 crc;
+        quint32 size;
+        quint32 offset;
+    };
+
+    QByteArray localHeader(const Entry &entry) const;
+    QByteArray sheetTail(const QByteArray &rows, const Entry &sheetEntry) const;
+    bool writeAt(qint64 pos, const QByteArray &data);
+    bool writeSheetTail(const QByteArray &rows);
+
+    QXlsx::Document *doc;
+    QFile file;
+    QTimer timer;
+
+    QVector<Entry> entries;  // the last entry is always the worksheet
+    QByteArray sheetSuffix;  // everything in the worksheet after the last row
+    quint32 sheetCrc;        // crc of the worksheet up to the suffix
+    quint32 sheetSize;       // size of the worksheet up to the suffix
+    qint64 appendPos;        // file position where the next rows are written
+    int savedRows;           // last row of the document that is in the file
+    quint16 dosTime;
+    quint16 dosDate;
+};
+
+#endif // AUTOSAVE_H
@@ -0,0 +1,47 @@
+# Copyright (C) 2019  Anthony Arrowood
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#-------------------------------------------------
+#
+# Command line tool converting the session csv files in log_files to excel files
+#
+#-------------------------------------------------
+
+QT       += core gui concurrent
+
+TARGET = batch_export
+TEMPLATE = app
+CONFIG += console static \
+c+=11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# QXlsx code, shared with the game
+QXLSX_PARENTPATH=../
+QXLSX_HEADERPATH=../header/
+QXLSX_SOURCEPATH=../source/
+include(../QXlsx.pri)
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        main.cpp \
+        ../autosave.cpp
+
+HEADERS += \
+        ../autosave.h
@@ -0,0 +1,309 @@
+/*
+Copyright (C) 2019  Anthony Arrowood
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QtNumeric>
+
+#include "autosave.h"
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+
+#define CHUNK_ROWS 4096   // rows parsed before they are appended to the excel file
+
+static QMutex outputMutex;
+
+/**
+ * Statistics of one converted session, printed as soon as the session is done.
+ */
+struct Result
+{
+    QString name;
+    qint64 rows;
+    qint64 bytes;
+    qint64 ms;
+    bool ok;
+};
+
+static void report(const Result &result)
+{
+    QMutexLocker locker(&outputMutex);
+    QTextStream out(stdout);
+    if (!result.ok) {
+        out << "  " << result.name << ": failed\n";
+        return;
+    }
+    const double seconds = qMax<qint64>(result.ms, 1) / 1000.0;
+    out << "  " << result.name << ": " << result.rows << " rows, "
+        << QString::number(result.bytes / 1048576.0, 'f', 2) << " MB in " << result.ms << " ms ("
+        << qRound64(result.rows / seconds) << " rows/s, "
+        << QString::number(result.bytes / 1048576.0 / seconds, 'f', 2) << " MB/s)\n";
+    out.flush();
+}
+
+/**
+ * Reads the header line of the csv file \a file into \a header.
+ */
+static bool readHeader(QFile &file, QStringList &header)
+{
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+    header.clear();
+    for (const QByteArray &name : file.readLine().split(','))
+        header << QString::fromLatin1(name.trimmed());
+    return !header.isEmpty();
+}
+
+/**
+ * Parses the next data line of \a file into \a columns numbers appended to \a values.
+ * Missing or malformed fields become NaN. Returns false at the end of the file.
+ */
+static bool readRow(QFile &file, int columns, QVector<double> &values)
+{
+    QByteArray line;
+    do {
+        if (file.atEnd())
+            return false;
+        line = file.readLine().trimmed();
+    } while (line.isEmpty());
+
+    const QList<QByteArray> fields = line.split(',');
+    for (int col = 0; col < columns; col++) {
+        bool ok = false;
+        const double value = col < fields.size() ? fields[col].trimmed().toDouble(&ok) : 0;
+        values.append(ok ? value : qQNaN());
+    }
+    return true;
+}
+
+
+/**
+ * Converts one session csv file to an excel file of the same name in the output directory.
+ * The csv is streamed CHUNK_ROWS rows at a time straight into the worksheet entry of the
+ * package by Autosave, so memory use does not grow with the length of the session.
+ */
+struct ConvertToFile
+{
+    typedef Result result_type;
+
+    QDir outputDir;
+
+    Result operator()(const QString &csvPath) const
+    {
+        QElapsedTimer timer;
+        timer.start();
+        QFile file(csvPath);
+        Result result = { QFileInfo(csvPath).completeBaseName(), 0, file.size(), 0, false };
+
+        QStringList header;
+        if (readHeader(file, header)) {
+            QXlsx::Document doc;
+            for (int col = 0; col < header.size(); col++)
+                doc.write(1, col + 1, header[col]);
+
+            Autosave saver(&doc);
+            if (saver.start(this->outputDir.filePath(result.name + ".xlsx"), 0)) {
+                result.ok = true;
+                QVector<double> chunk;
+                chunk.reserve(CHUNK_ROWS * header.size());
+                bool more = true;
+                while (more && result.ok) {
+                    more = readRow(file, header.size(), chunk);
+                    const int rows = chunk.size() / header.size();
+                    if (rows == CHUNK_ROWS || (!more && rows > 0)) {
+                        result.ok = saver.appendRows(rows, header.size(), chunk.constData());
+                        result.rows += rows;
+                        chunk.clear();
+                    }
+                }
+                saver.stop();
+            }
+        }
+
+        result.ms = timer.elapsed();
+        report(result);
+        return result;
+    }
+};
+
+/**
+ * A session csv file parsed into memory, used when every session goes to one workbook.
+ */
+struct Session
+{
+    Result result;
+    QStringList header;
+    QVector<double> values;
+};
+
+struct ParseSession
+{
+    typedef Session result_type;
+
+    Session operator()(const QString &csvPath) const
+    {
+        QElapsedTimer timer;
+        timer.start();
+        QFile file(csvPath);
+        Session session;
+        session.result = { QFileInfo(csvPath).completeBaseName(), 0, file.size(), 0, false };
+
+        if (readHeader(file, session.header)) {
+            while (readRow(file, session.header.size(), session.values))
+                session.result.rows++;
+            session.result.ok = true;
+        }
+
+        session.result.ms = timer.elapsed();
+        report(session.result);
+        return session;
+    }
+};
+
+/**
+ * Writes every session to its own worksheet of \a fileName.
+ * The csv files are parsed in parallel, the workbook itself is assembled on this thread.
+ * Unlike ConvertToFile all sessions are held in memory until the workbook is saved: Autosave only
+ * streams the single sheet of its own package, and a QXlsx::Document keeps every cell of every sheet.
+ */
+static bool writeWorkbook(const QStringList &csvPaths, const QString &fileName, QList<Result> &results)
+{
+    const QList<Session> sessions = QtConcurrent::blockingMapped<QList<Session> >(csvPaths, ParseSession());
+
+    QXlsx::Document doc;
+    bool first = true;
+    for (const Session &session : sessions) {
+        results << session.result;
+        if (!session.result.ok)
+            continue;
+        // sheet names are limited to 31 characters
+        QString name = session.result.name.left(31);
+        if (first)
+            doc.renameSheet(doc.currentSheet()->sheetName(), name);
+        else if (!doc.addSheet(name))
+            doc.addSheet();
+        first = false;
+
+        QXlsx::Worksheet *sheet = doc.currentWorksheet();
+        const int columns = session.header.size();
+        for (int col = 0; col < columns; col++)
+            sheet->write(1, col + 1, session.header[col]);
+        const double *value = session.values.constData();
+        for (int row = 2; row < session.result.rows + 2; row++) {
+            for (int col = 1; col <= columns; col++, value++) {
+                if (!qIsNaN(*value))
+                    sheet->write(row, col, *value);
+            }
+        }
+    }
+    if (first)
+        return false;
+    doc.selectSheet(doc.sheetNames().first());
+    return doc.saveAs(fileName);
+}
+
+
+int main(int argc, char *argv[])
+{
+    // QXlsx formats use QFont, which needs a gui application even though no window is shown
+    QGuiApplication a(argc, argv);
+    QCoreApplication::setApplicationName("batch_export");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Converts the session csv files of the game to excel files.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("directory", "Directory with the *-Game.csv files, log_files by default.");
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "Output directory, or the workbook file with --single. Defaults to the input directory.", "path");
+    QCommandLineOption singleOption(QStringList() << "s" << "single",
+                                    "Write one workbook with a sheet per session instead of one file per session. Holds all sessions in memory.");
+    QCommandLineOption jobsOption(QStringList() << "j" << "jobs",
+                                  "Number of sessions converted at the same time, one per core by default.", "count");
+    parser.addOption(outputOption);
+    parser.addOption(singleOption);
+    parser.addOption(jobsOption);
+    parser.process(a);
+
+    QTextStream out(stdout);
+    const QStringList args = parser.positionalArguments();
+    const QDir inputDir(args.isEmpty() ? QString("log_files") : args.first());
+    QStringList csvPaths;
+    for (const QFileInfo &info : inputDir.entryInfoList(QStringList() << "*-Game.csv", QDir::Files, QDir::Name))
+        csvPaths << info.absoluteFilePath();
+    if (csvPaths.isEmpty()) {
+        out << "No session files in " << inputDir.absolutePath() << "\n";
+        return 1;
+    }
+
+    if (parser.isSet(jobsOption) && parser.value(jobsOption).toInt() > 0)
+        QThreadPool::globalInstance()->setMaxThreadCount(parser.value(jobsOption).toInt());
+
+    // QXlsx fills some lookup tables the first time a package is written, do it here before
+    // the worker threads race for them
+    {
+        QXlsx::Document warmUp;
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        warmUp.write(1, 1, 0.0);
+        warmUp.saveAs(&buffer);
+    }
+
+    out << "Converting " << csvPaths.size() << " sessions on " << QThreadPool::globalInstance()->maxThreadCount() << " threads\n";
+    out.flush();
+
+    QElapsedTimer timer;
+    timer.start();
+    QList<Result> results;
+    bool ok = true;
+    if (parser.isSet(singleOption)) {
+        const QString fileName = parser.isSet(outputOption) ? parser.value(outputOption) : inputDir.filePath("sessions.xlsx");
+        ok = writeWorkbook(csvPaths, fileName, results);
+        if (!ok)
+            out << "Failed to write " << fileName << "\n";
+    } else {
+        const QDir outputDir(parser.isSet(outputOption) ? parser.value(outputOption) : inputDir.absolutePath());
+        if (!outputDir.exists())
+            outputDir.mkpath(".");
+        ConvertToFile convert;
+        convert.outputDir = outputDir;
+        results = QtConcurrent::blockingMapped<QList<Result> >(csvPaths, convert);
+    }
+
+    qint64 rows = 0;
+    qint64 bytes = 0;
+    for (const Result &result : results) {
+        rows += result.rows;
+        bytes += result.bytes;
+        ok = ok && result.ok;
+    }
+    const qint64 ms = timer.elapsed();
+    out << "Done in " << ms << " ms";
+    if (!results.isEmpty())
+        out << ", " << rows << " rows, " << QString::number(bytes / 1048576.0 / (qMax<qint64>(ms, 1) / 1000.0), 'f', 2) << " MB/s overall";
+    out << "\n";
+
+    return ok ? 0 : 1;
+}
@@ -80,6 +80,9 @@ private:
 		const Format &format = Format(), 
 		Worksheet *parent = NULL,
 		qint32 styleIndex = (-1) );
+	Cell(double data, CellType type, const Format &format, Worksheet *parent);
+	Cell(bool data, CellType type, const Format &format, Worksheet *parent);
+	Cell(const QString &data, CellType type, const Format &format, Worksheet *parent);
 	Cell(const Cell * const cell);
 	CellPrivate * const d_ptr;
 };
@@ -21,6 +21,7 @@
 #include <QtGlobal>
 #include <QList>
 #include <QSharedPointer>
+#include <QScopedPointer>
 
 QT_BEGIN_NAMESPACE_XLSX
 
@@ -31,18 +32,49 @@ public:
     CellPrivate(Cell *p);
     CellPrivate(const CellPrivate * const cp);
 
+    // How the value is stored, independent of Cell::CellType
+    enum ValueType : quint8 {
+        VT_Invalid, // blank cell
+        VT_Double,
+        VT_Bool,
+        VT_String
+    };
+
+    // Only string, rich text and formula cells need this,
+    // so it is allocated on first use
+    struct ExtraData
+    {
+        QString string;
+        CellFormula formula;
+        RichString richString;
+    };
+
+    QVariant value() const;
+    double toDouble() const;
+    bool isValid() const { return valueType != VT_Invalid; }
+    void setValue(const QVariant &data);
+    void setValue(double number);
+    void setValue(bool boolean);
+    void setValue(const QString &string);
+
+    CellFormula formula() const;
+    RichString richString() const;
+    ExtraData &extraData();
+
 public:
-    QVariant value;
-    CellFormula formula;
+    union {
+        double number;
+        bool boolean;
+    } data;
+    ValueType valueType;
     Cell::CellType cellType;
+	qint32 styleNumber;
     Format format;
 
-    RichString richString;
-
     Worksheet *parent;
     Cell *q_ptr;
 
-	qint32 styleNumber;
+    QScopedPointer<ExtraData> extra;
 };
 
 QT_END_NAMESPACE_XLSX
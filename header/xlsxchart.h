@@ -39,6 +39,7 @@ class AbstractSheet;
 class Worksheet;
 class ChartPrivate;
 class CellRange;
+class CellReference;
 class DrawingAnchor;
 // class XlsxAxis;
 // enum XlsxAxisPos : short;
@@ -78,6 +79,8 @@ public:
     ~Chart();
 
     void addSeries(const CellRange &range, AbstractSheet *sheet=0);
+    void addSeries(const CellRange &keyRange, const CellRange &valRange, AbstractSheet *sheet=0, const CellReference &nameCell=CellReference());
+    void clearSeries();
     void setChartType(ChartType type);
     void setChartStyle(int id);
     void setAxisTitle(Chart::ChartAxisPos pos, QString axisTitle);
@@ -59,6 +59,7 @@ public:
     //At present, we care about number cell ranges only!
     QString numberDataSource_numRef; // yval, val
     QString axDataSource_numRef; // xval, cat
+    QString seriesName_strRef; // tx
 };
 
 class XlsxAxis
@@ -42,6 +42,8 @@ public:
 	
 	QVariant read(const CellReference &cell) const;
 	QVariant read(int row, int col) const;
+	int readRange(const CellRange &range, double *out) const;
+	int readColumn(int column, int firstRow, int lastRow, double *out) const;
 	
 	bool insertImage(int row, int col, const QImage &image);
 	
@@ -271,6 +271,7 @@ private:
     friend   QDebug operator<<(QDebug, const Format &f);
 
     int theme() const;
+    static bool isBuiltinDateTimeFormat(int id);
 
     QExplicitlySharedDataPointer<FormatPrivate> d;
 };
@@ -58,10 +58,11 @@ class XlsxColor;
 
 struct XlsxFormatNumberData
 {
-    XlsxFormatNumberData() : formatIndex(0) {}
+    XlsxFormatNumberData() : formatIndex(0), isDateTime(false) {}
 
     int formatIndex;
     QString formatString;
+    bool isDateTime; //classification of formatString, computed once
 };
 
 class Styles : public AbstractOOXmlFile
@@ -73,6 +74,7 @@ public:
     Format xfFormat(int idx) const;
     void addDxfFormat(const Format &format, bool force=false);
     Format dxfFormat(int idx) const;
+    bool isDateTimeFormat(const Format &format) const;
 
     void saveToXmlFile(QIODevice *device) const;
     bool loadFromXmlFile(QIODevice *device);
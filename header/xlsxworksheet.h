@@ -57,6 +57,8 @@ public:
     bool write(int row, int column, const QVariant &value, const Format &format=Format());
     QVariant read(const CellReference &row_column) const;
     QVariant read(int row, int column) const;
+    int readRange(const CellRange &range, double *out) const;
+    int readColumn(int column, int firstRow, int lastRow, double *out) const;
     bool writeString(const CellReference &row_column, const QString &value, const Format &format=Format());
     bool writeString(int row, int column, const QString &value, const Format &format=Format());
     bool writeString(const CellReference &row_column, const RichString &value, const Format &format=Format());
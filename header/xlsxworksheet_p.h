@@ -162,7 +162,7 @@ public:
     int checkDimensions(int row, int col, bool ignore_row=false, bool ignore_col=false);
     Format cellFormat(int row, int col) const;
     QString generateDimensionString() const;
-    void calculateSpans() const;
+    void insertCell(int row, int col, const QSharedPointer<Cell> &cell);
     void splitColsInfo(int colFirst, int colLast);
     void validateDimension();
 
@@ -189,6 +189,7 @@ public:
     bool isColumnRangeValid(int colFirst, int colLast);
 
     SharedStrings *sharedStrings() const;
+    static bool numericCellValue(const Cell *cell, double *value);
 
     QMap<int, QMap<int, QSharedPointer<Cell> > > cellTable;
     QMap<int, QMap<int, QString> > comments;
@@ -205,7 +206,7 @@ public:
     CellRange dimension;
     int previous_row;
 
-    mutable QMap<int, QString> row_spans;
+    QMap<int, QPair<int, int> > row_spans;
     QMap<int, double> row_sizes;
     QMap<int, double> col_sizes;
 
@@ -19,6 +19,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include <QTextCursor>
+#include <QtNumeric>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QSettings>
+#include <QInputDialog>
 
 
 
@@ -28,7 +33,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::MainWindow)
+    ui(new Ui::MainWindow),
+    autosave(&xldoc)
 {
 
     ui->setupUi(this);
@@ -66,6 +72,10 @@ MainWindow::MainWindow(QWidget *parent) :
     newDir.cdUp();
     QDir::setCurrent(newDir.path());
 
+    // the autosave interval is set in the file menu and kept between runs
+    QSettings settings(SETTINGS_FILE, QSettings::IniFormat);
+    this->autosaveIntervalMs = qMax(1000, settings.value("autosave/intervalMs", AUTOSAVE_INTERVAL_MS).toInt());
+
     // create the media player
     this->player = new QMediaPlayer;
     player->setMedia(QUrl("qrc:/sound/alarm.wav"));
@@ -106,6 +116,28 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->plot->graph(3)->setName("Percent Heater on");
     ui->plot->graph(3)->setPen(QPen(QColor("purple"))); // line color for the first graph
 
+    // long sessions are drawn from a min/max index instead of walking every sample on each replot,
+    // and while the ranges stay the same only the line segments to new samples are drawn
+    for (int i = 0; i < ui->plot->graphCount(); i++) {
+        ui->plot->graph(i)->setAdaptiveSamplingIndex(true);
+        ui->plot->graph(i)->setIncrementalDrawing(true);
+    }
+
+    // the graphs get their own paint buffer, so a new sample only redraws them and keeps
+    // the background, grid and axes until the ranges change
+    ui->plot->layer("main")->setMode(QCPLayer::lmBuffered);
+    ui->plot->setPlottingHint(QCP::phIncrementalReplot);
+    // draw the graphs in parallel to the background, grid and axes
+    ui->plot->setThreadedReplot(true);
+    // replot at most once per screen refresh, however fast samples or wheel events arrive
+    ui->plot->setMaxFrameRate(QGuiApplication::primaryScreen()->refreshRate());
+    // with PWCL_PLOT_PROFILE set, the plot shows where the time of each replot goes and the
+    // recent replots are written to plot-trace.json on exit (open it with chrome://tracing)
+    if (qEnvironmentVariableIsSet("PWCL_PLOT_PROFILE")) {
+        ui->plot->setProfilerFrames(PLOT_PROFILE_FRAMES);
+        ui->plot->setProfilerOverlay(true);
+    }
+
     ui->plot->xAxis2->setVisible(true);  // show x ticks at top
     ui->plot->xAxis2->setVisible(false); // dont show labels at top
     ui->plot->yAxis2->setVisible(true);  // right y axis labels
@@ -121,6 +153,36 @@ MainWindow::MainWindow(QWidget *parent) :
     ar->setRangeDragAxes(ui->plot->xAxis, ui->plot->yAxis2);
     ar->setRangeZoomAxes(ui->plot->xAxis, ui->plot->yAxis2);
 
+    // hover readout of the samples under the mouse. It is drawn on the buffered overlay layer,
+    // so moving the mouse only repaints that layer and not the graphs
+    this->hoverLine = new QCPItemStraightLine(ui->plot);
+    this->hoverLine->setLayer("overlay");
+    this->hoverLine->setPen(QPen(Qt::gray, 0, Qt::DashLine));
+    this->hoverLine->setSelectable(false);
+    this->hoverLine->setVisible(false);
+
+    this->hoverTracer = new QCPItemTracer(ui->plot);
+    this->hoverTracer->setLayer("overlay");
+    this->hoverTracer->setGraph(ui->plot->graph(2));  // snap to the temperature samples
+    this->hoverTracer->setInterpolating(false);
+    this->hoverTracer->setStyle(QCPItemTracer::tsCircle);
+    this->hoverTracer->setSize(7);
+    this->hoverTracer->setPen(QPen(Qt::blue));
+    this->hoverTracer->setSelectable(false);
+    this->hoverTracer->setVisible(false);
+
+    this->hoverLabel = new QCPItemText(ui->plot);
+    this->hoverLabel->setLayer("overlay");
+    this->hoverLabel->position->setType(QCPItemPosition::ptAbsolute);  // pixel offset from the tracer
+    this->hoverLabel->position->setParentAnchor(this->hoverTracer->position);
+    this->hoverLabel->setTextAlignment(Qt::AlignLeft);
+    this->hoverLabel->setPadding(QMargins(4, 2, 4, 2));
+    this->hoverLabel->setPen(QPen(Qt::gray));
+    this->hoverLabel->setBrush(QBrush(QColor(255, 255, 255, 220)));
+    this->hoverLabel->setSelectable(false);
+    this->hoverLabel->setVisible(false);
+
+    connect(ui->plot, &QCustomPlot::mouseMove, this, &MainWindow::plotMouseMove);
 }
 
 
@@ -154,6 +216,9 @@ void MainWindow::closeEvent( QCloseEvent* event )
 MainWindow::~MainWindow()
 {
     this->csvdoc.close();
+    this->autosave.stop();
+    if (ui->plot->profilerFrames() > 0)
+        ui->plot->saveProfilerTrace("plot-trace.json");
 
     delete player;
     delete ui;
@@ -208,6 +273,11 @@ void MainWindow::showRequest(const QString &req)
                 qDebug() << " \n ERROR : " << err;
             }
 
+            // keep a crash safe copy of the excel file next to the csv file
+            this->autosaveFileName = "..\\log_files\\" + dateStr + "-Game.xlsx";
+            if (ui->actionAutosave_Excel_File->isChecked())
+                this->autosave.start(this->autosaveFileName, this->autosaveIntervalMs);
+
         }
 
         double time       = static_cast<double>(com.get(i_time));
@@ -285,10 +355,8 @@ void MainWindow::showRequest(const QString &req)
         /*
         *  Place the latest values in the graph
         */
-        ui->plot->graph(3)->addData( time,  percentOn);
-        ui->plot->graph(2)->addData( time,  temp);
-        ui->plot->graph(1)->addData( time,  tempFilt);
-        ui->plot->graph(0)->addData( time,  setPoint);
+        const double graphValues[] = { setPoint, tempFilt, temp, percentOn };   // one value per graph, in the order the graphs were added
+        ui->plot->addGraphData( time, graphValues, int(sizeof(graphValues)/sizeof(graphValues[0])) );
         ui->plot->replot( QCustomPlot::rpQueuedReplot );
         if (ui->auto_fit_CheckBox->isChecked())
             ui->plot->rescaleAxes(); // should be in a button or somethng
@@ -447,12 +515,79 @@ void MainWindow::on_actionExport_Excel_File_triggered()
     qDebug() << "Saving excel file with Filename: " << this->excelFileName << "\n";
 
     if(!this->excelFileName.isNull()) {    // The user chose a valid filname
+        writeChart();
         this->xldoc.saveAs(this->excelFileName);
     }
 
 }
 
 
+/**
+ * @brief MainWindow::writeChart
+ * Adds (or refreshes) a chart sheet that plots Temperature, Set Point and Percent On against Time.
+ * Sessions longer than CHART_MAX_POINTS rows are charted from a "Summary" sheet holding the
+ * mean of each column over CHART_MAX_POINTS equal buckets, so Excel does not have to draw every sample.
+ * The data sheet stays the current sheet so that new rows keep going to it.
+ */
+void MainWindow::writeChart()
+{
+    QXlsx::Worksheet *dataSheet = this->xldoc.currentWorksheet();
+    const int lastRow = ui->outputTable->rowCount();
+    if (!dataSheet || lastRow < 2)
+        return;
+    const QString dataSheetName = dataSheet->sheetName();
+
+    if (!this->xldoc.sheet("Chart"))
+        this->xldoc.addSheet("Chart", QXlsx::AbstractSheet::ST_ChartSheet);
+    QXlsx::Chart *chart = static_cast<QXlsx::Chartsheet *>(this->xldoc.sheet("Chart"))->chart();
+    chart->setChartType(QXlsx::Chart::CT_Scatter);
+    chart->setAxisTitle(QXlsx::Chart::Bottom, "Time");
+    chart->setAxisTitle(QXlsx::Chart::Left, "Temperature / Percent On");
+    chart->clearSeries();
+
+    QXlsx::Worksheet *chartSource = dataSheet;
+    int chartLastRow = lastRow;
+    if (lastRow - 1 > CHART_MAX_POINTS) {
+        if (!this->xldoc.sheet("Summary"))
+            this->xldoc.addSheet("Summary");
+        chartSource = static_cast<QXlsx::Worksheet *>(this->xldoc.sheet("Summary"));
+        chartLastRow = CHART_MAX_POINTS + 1;
+
+        const int rows = lastRow - 1;
+        const int cols = 6;
+        QVector<double> values(rows * cols);
+        dataSheet->readRange(QXlsx::CellRange(2, 1, lastRow, cols), values.data());
+
+        for (int col = 1; col <= cols; col++)
+            chartSource->write(1, col, dataSheet->read(1, col));
+        for (int bucket = 0; bucket < CHART_MAX_POINTS; bucket++) {
+            const int first = static_cast<int>(static_cast<qint64>(bucket) * rows / CHART_MAX_POINTS);
+            const int last = static_cast<int>(static_cast<qint64>(bucket + 1) * rows / CHART_MAX_POINTS);
+            for (int col = 0; col < cols; col++) {
+                double sum = 0;
+                int count = 0;
+                for (int row = first; row < last; row++) {
+                    const double value = values[row * cols + col];
+                    if (!qIsNaN(value)) {
+                        sum += value;
+                        count++;
+                    }
+                }
+                if (count)
+                    chartSource->write(bucket + 2, col + 1, sum / count);
+            }
+        }
+    }
+
+    const QXlsx::CellRange time(2, 1, chartLastRow, 1);
+    chart->addSeries(time, QXlsx::CellRange(2, 3, chartLastRow, 3), chartSource, QXlsx::CellReference(1, 3));  // Temperature
+    chart->addSeries(time, QXlsx::CellRange(2, 5, chartLastRow, 5), chartSource, QXlsx::CellReference(1, 5));  // Set Point
+    chart->addSeries(time, QXlsx::CellRange(2, 2, chartLastRow, 2), chartSource, QXlsx::CellReference(1, 2));  // Percent On
+
+    this->xldoc.selectSheet(dataSheetName);
+}
+
+
 /**
  * @brief MainWindow::on_auto_fit_CheckBox_stateChanged
  * Called when the user clicked the auto-fit checkbox, changes the default settings of the graph to fit the data.
@@ -495,6 +630,94 @@ void MainWindow::on_zoomy_checkBox_stateChanged(int arg1)
 }
 
 
+/**
+ * Called when the user toggles the autosave option in the dropdown menu of file.
+ * Autosaving can only start once a session has begun since the file is named after the session.
+ */
+void MainWindow::on_actionAutosave_Excel_File_toggled(bool checked)
+{
+    if (!checked)
+        this->autosave.stop();
+    else if (this->validConnection && !this->autosave.isActive())
+        this->autosave.start(this->autosaveFileName, this->autosaveIntervalMs);
+}
+
+/**
+ * Called when the user clicks the autosave interval option in the dropdown menu of file.
+ * Asks for the seconds between autosaves, applies them to a running autosave and stores them in the settings.
+ */
+void MainWindow::on_actionAutosave_Interval_triggered()
+{
+    bool ok = false;
+    int seconds = QInputDialog::getInt(this, "Autosave Interval", "Seconds between autosaves:",
+                                       this->autosaveIntervalMs / 1000, 1, 3600, 1, &ok);
+    if (!ok)
+        return;
+    this->autosaveIntervalMs = seconds * 1000;
+    this->autosave.setInterval(this->autosaveIntervalMs);
+    QSettings settings(SETTINGS_FILE, QSettings::IniFormat);
+    settings.setValue("autosave/intervalMs", this->autosaveIntervalMs);
+}
+
+/**
+ * Called when the mouse moves over the plot.
+ * Snaps the hover readout to the sample nearest to the mouse and lists the values of all graphs at
+ * that time. Only the overlay layer is repainted.
+ */
+void MainWindow::plotMouseMove(QMouseEvent *event)
+{
+    QCPGraph *temperature = ui->plot->graph(2);
+    bool show = ui->plot->axisRect()->rect().contains(event->pos()) && !temperature->data()->isEmpty();
+    if (!show && !this->hoverTracer->visible())
+        return;
+
+    if (show) {
+        // the tracer finds the nearest sample with a binary search of the graph data
+        this->hoverTracer->setGraphKey(ui->plot->xAxis->pixelToCoord(event->pos().x()));
+        this->hoverTracer->updatePosition();
+        double time = this->hoverTracer->position->key();
+        this->hoverLine->point1->setCoords(time, 0);
+        this->hoverLine->point2->setCoords(time, 1);
+
+        // all graphs get their samples at the same times
+        QString text = QString("Time: %1 min").arg(time, 0, 'f', 2);
+        for (int i = 0; i < ui->plot->graphCount(); i++) {
+            QCPGraph *graph = ui->plot->graph(i);
+            QCPGraphDataContainer::const_iterator it = graph->data()->findBegin(time, false);
+            if (it != graph->data()->constEnd() && it->key == time)
+                text += QString("\n%1: %2").arg(graph->name()).arg(it->value, 0, 'f', 2);
+        }
+        this->hoverLabel->setText(text);
+
+        // keep the label inside the plot by placing it on the side facing the center
+        if (event->pos().x() > ui->plot->axisRect()->center().x()) {
+            this->hoverLabel->setPositionAlignment(Qt::AlignRight | Qt::AlignBottom);
+            this->hoverLabel->position->setCoords(-8, -8);
+        } else {
+            this->hoverLabel->setPositionAlignment(Qt::AlignLeft | Qt::AlignBottom);
+            this->hoverLabel->position->setCoords(8, -8);
+        }
+    }
+
+    this->hoverLine->setVisible(show);
+    this->hoverTracer->setVisible(show);
+    this->hoverLabel->setVisible(show);
+    ui->plot->layer("overlay")->replot();
+}
+
+/**
+ * Called when the user clicks the compare sessions option in the dropdown menu of file.
+ * Shows the temperature traces of every session in the chosen folder as one density image.
+ */
+void MainWindow::on_actionCompare_Sessions_triggered()
+{
+    QString dir = QFileDialog::getExistingDirectory(this, "Folder with the sessions to compare", QDir::currentPath());
+    if (dir.isEmpty())
+        return;
+    SessionDensity *density = new SessionDensity(dir);
+    density->show();
+}
+
 void MainWindow::on_actionAbout_triggered()
 {
     About* ab = new About();
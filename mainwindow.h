@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMainWindow>
 #include <QMediaPlayer>
 #include "about.h"
+#include "sessiondensity.h"
 
 #include "xlsxdocument.h"
 #include "xlsxchartsheet.h"
@@ -32,6 +33,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 using namespace QXlsx;
 
 #include "port.h"
+#include "autosave.h"
 #include "PWCL_game\com.h"
 
 
@@ -45,11 +47,21 @@ using namespace QXlsx;
 #define i_avg_err      7
 #define i_score        8
 
+#define AUTOSAVE_INTERVAL_MS 10000  // default of how often the session workbook is written to the log_files folder
+#define SETTINGS_FILE "settings.ini"  // user settings, kept next to the log_files folder
+#define CHART_MAX_POINTS     4000   // longer sessions are charted from a decimated summary sheet
+#define PLOT_PROFILE_FRAMES  600    // replots kept by the plot profiler when PWCL_PLOT_PROFILE is set
+
 
 namespace Ui {
 class MainWindow;
 }
 
+class QMouseEvent;
+class QCPItemTracer;
+class QCPItemStraightLine;
+class QCPItemText;
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -80,6 +92,13 @@ private slots:
 
     void on_actionAbout_triggered();
 
+    void on_actionAutosave_Excel_File_toggled(bool checked);
+
+    void on_actionAutosave_Interval_triggered();
+
+    void on_actionCompare_Sessions_triggered();
+    void plotMouseMove(QMouseEvent *event);
+
 private:
     COM com;
 
@@ -89,13 +108,20 @@ private:
     int timerId;
     void timerEvent(QTimerEvent *event);
     void closeEvent(QCloseEvent* event);
+    void writeChart();
     PORT port;
     bool validConnection;
 
     QString excelFileName;
     QXlsx::Document xldoc;
+    Autosave autosave;   // must be declared after xldoc
+    QString autosaveFileName;
+    int autosaveIntervalMs;
     QFile csvdoc;
     QMediaPlayer* player;
+    QCPItemTracer *hoverTracer;       // hover readout, lives on the plot's overlay layer
+    QCPItemStraightLine *hoverLine;
+    QCPItemText *hoverLabel;
 
 protected:
     bool event(QEvent *event);
@@ -25,6 +25,23 @@
 
 #include "qcustomplot.h"
 
+#include <QtCore/QFile>
+#include <QtCore/QDataStream>
+#include <QtGui/QPaintEngine>
+#include <QtGui/QFontDatabase>
+
+// x86 SIMD kernels are compiled with per-function target attributes, so no global compiler flags are needed:
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+#  define QCP_SIMD_X86
+#  define QCP_SIMD_TARGET(isa) __attribute__((target(isa)))
+#  include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#  define QCP_SIMD_X86
+#  define QCP_SIMD_TARGET(isa)
+#  include <intrin.h>
+#  include <immintrin.h>
+#endif
+
 
 /* including file 'src/vector2d.cpp', size 7340                              */
 /* commit ce344b3f96a62e5f652585e55f1ae7c7883cd45b 2018-06-25 01:03:39 +0200 */
@@ -560,6 +577,27 @@ void QCPPainter::makeNonCosmetic()
   default implementation does nothing.
 */
 
+/*! \fn virtual int QCPAbstractPaintBuffer::tileCount() const
+
+  Returns the number of horizontal bands (tiles) the buffer is divided into. The tiles can be
+  painted on concurrently with painters obtained by \ref startPaintingTile.
+
+  The default implementation returns 1, i.e. the whole buffer is a single tile.
+*/
+
+/*! \fn virtual QCPPainter *QCPAbstractPaintBuffer::startPaintingTile(int index)
+
+  Returns a \ref QCPPainter which draws to the tile with the given \a index (see \ref tileCount).
+  The painter uses the same coordinates as one returned by \ref startPainting, but only the pixels
+  of the tile are changed. Painters of different tiles may be used at the same time, from different
+  threads.
+
+  As with \ref startPainting, the caller takes ownership of the painter. Once all tiles are painted
+  and their painters deleted, call \ref donePainting.
+
+  The default implementation returns \ref startPainting for the single tile with index 0.
+*/
+
 /* end documentation of inline functions */
 
 /*!
@@ -707,6 +745,157 @@ void QCPPaintBufferPixmap::reallocateBuffer()
 }
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPPaintBufferImage
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPPaintBufferImage
+  \brief A paint buffer based on QImage, using software raster rendering
+
+  This paint buffer works like \ref QCPPaintBufferPixmap, but uses a QImage with format \c
+  QImage::Format_ARGB32_Premultiplied as internal buffer. Unlike pixmaps, images may be painted on
+  in any thread, so this paint buffer is used if \ref QCustomPlot::setThreadedReplot is enabled.
+*/
+
+/*!
+  Creates an image paint buffer instance with the specified \a size and \a devicePixelRatio, if
+  applicable.
+*/
+QCPPaintBufferImage::QCPPaintBufferImage(const QSize &size, double devicePixelRatio) :
+  QCPAbstractPaintBuffer(size, devicePixelRatio)
+{
+  QCPPaintBufferImage::reallocateBuffer();
+}
+
+QCPPaintBufferImage::~QCPPaintBufferImage()
+{
+}
+
+/* inherits documentation from base class */
+QCPPainter *QCPPaintBufferImage::startPainting()
+{
+  QCPPainter *result = new QCPPainter(&mBuffer);
+  result->setRenderHint(QPainter::HighQualityAntialiasing);
+  return result;
+}
+
+/* inherits documentation from base class */
+void QCPPaintBufferImage::draw(QCPPainter *painter) const
+{
+  if (painter && painter->isActive())
+    painter->drawImage(0, 0, mBuffer);
+  else
+    qDebug() << Q_FUNC_INFO << "invalid or inactive painter passed";
+}
+
+/* inherits documentation from base class */
+void QCPPaintBufferImage::clear(const QColor &color)
+{
+  mBuffer.fill(color);
+}
+
+/* inherits documentation from base class */
+void QCPPaintBufferImage::reallocateBuffer()
+{
+  setInvalidated();
+  if (!qFuzzyCompare(1.0, mDevicePixelRatio))
+  {
+#ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
+    mBuffer = QImage(mSize*mDevicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    mBuffer.setDevicePixelRatio(mDevicePixelRatio);
+#else
+    qDebug() << Q_FUNC_INFO << "Device pixel ratios not supported for Qt versions before 5.4";
+    mDevicePixelRatio = 1.0;
+    mBuffer = QImage(mSize, QImage::Format_ARGB32_Premultiplied);
+#endif
+  } else
+  {
+    mBuffer = QImage(mSize, QImage::Format_ARGB32_Premultiplied);
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPPaintBufferTiledImage
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPPaintBufferTiledImage
+  \brief A QImage paint buffer that is divided into tiles which can be rendered in parallel
+
+  This paint buffer extends \ref QCPPaintBufferImage by dividing the image into horizontal bands
+  (see \ref tileCount). Each band is a separate QImage sharing the memory of the buffer, so the
+  bands can be painted on by different threads at the same time. \ref QCPLayer uses this to draw
+  layers in \ref QCPLayer::lmBuffered mode on the global QThreadPool, one band per thread, if they
+  have tiling enabled (\ref QCPLayer::setTiled), see \ref QCustomPlot::setReplotTiles.
+*/
+
+/*!
+  Creates a tiled image paint buffer instance with the specified \a size and \a devicePixelRatio,
+  if applicable. The buffer is divided into \a tiles bands of equal height, or less if the buffer
+  doesn't have that many pixel rows.
+*/
+QCPPaintBufferTiledImage::QCPPaintBufferTiledImage(const QSize &size, double devicePixelRatio, int tiles) :
+  QCPPaintBufferImage(size, devicePixelRatio),
+  mTileLimit(qMax(1, tiles))
+{
+  updateTiles();
+}
+
+QCPPaintBufferTiledImage::~QCPPaintBufferTiledImage()
+{
+}
+
+/* inherits documentation from base class */
+QCPPainter *QCPPaintBufferTiledImage::startPaintingTile(int index)
+{
+  if (index < 0 || index >= mTiles.size())
+  {
+    qDebug() << Q_FUNC_INFO << "tile index out of bounds:" << index;
+    return 0;
+  }
+  QCPPainter *result = new QCPPainter(&mTiles[index]);
+  result->setRenderHint(QPainter::HighQualityAntialiasing);
+  result->translate(0, -mTileOffsets.at(index)/mDevicePixelRatio);
+  return result;
+}
+
+/* inherits documentation from base class */
+void QCPPaintBufferTiledImage::reallocateBuffer()
+{
+  QCPPaintBufferImage::reallocateBuffer();
+  updateTiles();
+}
+
+/*! \internal
+
+  Divides the current image into bands and creates the tile images, which reference the pixel data
+  of the image. Must be called whenever the image was reallocated.
+
+  The tiles alias the bits of \a mBuffer without holding a reference to them. \a mBuffer must thus
+  never be shared with another QImage, since a detach (e.g. by \ref clear while a copy exists)
+  would move it to new memory, and the tiles would be drawn into the old one.
+*/
+void QCPPaintBufferTiledImage::updateTiles()
+{
+  mTiles.clear();
+  mTileOffsets.clear();
+  const int rows = mBuffer.height();
+  const int tiles = qMin(mTileLimit, rows);
+  uchar *bits = mBuffer.bits();
+  for (int i=0; i<tiles; ++i)
+  {
+    const int top = rows*i/tiles;
+    const int bottom = rows*(i+1)/tiles;
+    QImage tile(bits+top*mBuffer.bytesPerLine(), mBuffer.width(), bottom-top, mBuffer.bytesPerLine(), mBuffer.format());
+#ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
+    tile.setDevicePixelRatio(mDevicePixelRatio);
+#endif
+    mTiles.append(tile);
+    mTileOffsets.append(top);
+  }
+}
+
+
 #ifdef QCP_OPENGL_PBUFFER
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPPaintBufferGlPbuffer
@@ -1045,7 +1234,8 @@ QCPLayer::QCPLayer(QCustomPlot *parentPlot, const QString &layerName) :
   mName(layerName),
   mIndex(-1), // will be set to a proper value by the QCustomPlot layer creation function
   mVisible(true),
-  mMode(lmLogical)
+  mMode(lmLogical),
+  mTiled(false)
 {
   // Note: no need to make sure layerName is unique, because layer
   // management is done with QCustomPlot functions.
@@ -1097,7 +1287,7 @@ void QCPLayer::setVisible(bool visible)
   only the topmost layer called "overlay" is in mode \ref lmBuffered, and contains the selection
   rect.
 
-  \see replot
+  \see replot, setTiled
 */
 void QCPLayer::setMode(QCPLayer::LayerMode mode)
 {
@@ -1109,23 +1299,64 @@ void QCPLayer::setMode(QCPLayer::LayerMode mode)
   }
 }
 
+/*!
+  Sets whether this layer is drawn in parallel bands when the parent plot divides its paint buffers
+  into tiles (\ref QCustomPlot::setReplotTiles). Only layers in mode \ref lmBuffered can be tiled.
+
+  The layerables of a tiled layer are drawn by several threads at the same time, so only place
+  layerables on it which don't change their own state while drawing, typically plottables. Axes,
+  items and legends do, which is why no layer is tiled by default.
+
+  Tiling is also skipped when the platform can't render text outside the GUI thread (see
+  QFontDatabase::supportsThreadedFontRendering).
+*/
+void QCPLayer::setTiled(bool enabled)
+{
+  if (mTiled != enabled)
+  {
+    mTiled = enabled;
+    if (!mPaintBuffer.isNull())
+      mPaintBuffer.data()->setInvalidated();
+  }
+}
+
 /*! \internal
 
   Draws the contents of this layer with the provided \a painter.
 
+  While the parent plot records a replot profile (\ref QCustomPlot::setProfilerFrames), the time
+  each layerable takes to draw is added to it.
+
   \see replot, drawToPaintBuffer
 */
 void QCPLayer::draw(QCPPainter *painter)
 {
+  const bool profiling = mParentPlot->mProfileStart >= 0;
   foreach (QCPLayerable *child, mChildren)
   {
     if (child->realVisibility())
     {
+      const qint64 start = profiling ? mParentPlot->mFrameTimer.nsecsElapsed() : 0;
       painter->save();
       painter->setClipRect(child->clipRect().translated(0, -1));
       child->applyDefaultAntialiasingHint(painter);
       child->draw(painter);
       painter->restore();
+      if (profiling)
+      {
+        // plottables are profiled by name and with their number of data points, other layerables by class:
+        QString name;
+        int points = 0;
+        if (QCPAbstractPlottable *plottable = qobject_cast<QCPAbstractPlottable*>(child))
+        {
+          name = plottable->name();
+          if (plottable->interface1D())
+            points = plottable->interface1D()->dataCount();
+        }
+        if (name.isEmpty())
+          name = QString::fromLatin1(child->metaObject()->className());
+        mParentPlot->addProfileEntry(QCPReplotProfile::etLayerable, name, start, points);
+      }
     }
   }
 }
@@ -1142,20 +1373,90 @@ void QCPLayer::drawToPaintBuffer()
 {
   if (!mPaintBuffer.isNull())
   {
-    if (QCPPainter *painter = mPaintBuffer.data()->startPainting())
+    const qint64 start = mParentPlot->mFrameTimer.nsecsElapsed();
+    QCPAbstractPaintBuffer *buffer = mPaintBuffer.data();
+    const int tiles = mMode == lmBuffered && mTiled && QFontDatabase::supportsThreadedFontRendering() ? buffer->tileCount() : 1;
+    if (tiles > 1)
+    {
+      // the first tile is drawn before the others are started, so layerables may update lazily
+      // computed data (e.g. the map image of QCPColorMap) without racing against the other tiles:
+      drawTile(buffer, 0);
+      QSemaphore finished;
+      int started = 0;
+      for (int i=1; i<tiles; ++i)
+      {
+        TileTask *task = new TileTask(this, buffer, i, &finished);
+        if (QThreadPool::globalInstance()->tryStart(task))
+          ++started;
+        else
+        {
+          drawTile(buffer, i);
+          delete task;
+        }
+      }
+      finished.acquire(started);
+      buffer->donePainting();
+    } else if (QCPPainter *painter = buffer->startPainting())
     {
       if (painter->isActive())
         draw(painter);
       else
         qDebug() << Q_FUNC_INFO << "paint buffer returned inactive painter";
       delete painter;
-      mPaintBuffer.data()->donePainting();
+      buffer->donePainting();
     } else
       qDebug() << Q_FUNC_INFO << "paint buffer returned zero painter";
+    if (mParentPlot->mProfileStart >= 0)
+      mParentPlot->addProfileEntry(QCPReplotProfile::etLayer, mName, start);
   } else
     qDebug() << Q_FUNC_INFO << "no valid paint buffer associated with this layer";
 }
 
+/*! \internal
+
+  Draws one of the tiles of a \ref QCPPaintBufferTiledImage for \ref drawToPaintBuffer on a pool
+  thread.
+*/
+class QCPLayer::TileTask : public QRunnable
+{
+public:
+  TileTask(QCPLayer *layer, QCPAbstractPaintBuffer *buffer, int index, QSemaphore *finished) :
+    mLayer(layer), mBuffer(buffer), mIndex(index), mFinished(finished) {}
+  virtual void run() Q_DECL_OVERRIDE
+  {
+    mLayer->drawTile(mBuffer, mIndex);
+    mFinished->release();
+  }
+  
+private:
+  QCPLayer *mLayer;
+  QCPAbstractPaintBuffer *mBuffer;
+  int mIndex;
+  QSemaphore *mFinished;
+};
+
+/*! \internal
+
+  Draws the contents of this layer into the tile with the given \a index of \a buffer (see \ref
+  QCPAbstractPaintBuffer::startPaintingTile). The tiles of a buffer are drawn concurrently by \ref
+  drawToPaintBuffer, so the painter is in \ref QCPPainter::pmNoCaching mode, which keeps the
+  layerables from updating caches while drawing (e.g. the tick label cache of the axes).
+*/
+void QCPLayer::drawTile(QCPAbstractPaintBuffer *buffer, int index)
+{
+  if (QCPPainter *painter = buffer->startPaintingTile(index))
+  {
+    if (painter->isActive())
+    {
+      painter->setMode(QCPPainter::pmNoCaching);
+      draw(painter);
+    } else
+      qDebug() << Q_FUNC_INFO << "paint buffer returned inactive painter";
+    delete painter;
+  } else
+    qDebug() << Q_FUNC_INFO << "paint buffer returned zero painter";
+}
+
 /*!
   If the layer mode (\ref setMode) is set to \ref lmBuffered, this method allows replotting only
   the layerables on this specific layer, without the need to replot all other layers (as a call to
@@ -1175,9 +1476,11 @@ void QCPLayer::replot()
   {
     if (!mPaintBuffer.isNull())
     {
+      mParentPlot->beginProfile();
       mPaintBuffer.data()->clear(Qt::transparent);
       drawToPaintBuffer();
       mPaintBuffer.data()->setInvalidated(false);
+      mParentPlot->endProfile(false);
       mParentPlot->update();
     } else
       qDebug() << Q_FUNC_INFO << "no valid paint buffer associated with this layer";
@@ -5487,8 +5790,24 @@ void QCPLineEnding::draw(QCPPainter *painter, const QCPVector2D &pos, double ang
   
   See the documentation of all these virtual methods in QCPAxisTicker for detailed information
   about the parameters and expected return values.
+  
+  \ref QCPAxis only calls \ref generate again if the axis range or the \ref revision of the ticker
+  has changed. So if your ticker has own properties which influence the ticks or labels, increment
+  \c mRevision in their setters.
+*/
+
+/* start documentation of inline functions */
+
+/*! \fn int QCPAxisTicker::revision() const
+
+  Returns a counter that is incremented whenever a property of the ticker changes. \ref QCPAxis
+  uses it together with the axis range to decide whether the ticks and tick labels it obtained from
+  \ref generate are still valid, so unchanged axes don't regenerate and reformat their ticks on
+  every replot.
 */
 
+/* end documentation of inline functions */
+
 /*!
   Constructs the ticker and sets reasonable default values. Axis tickers are commonly created
   managed by a QSharedPointer, which then can be passed to QCPAxis::setTicker.
@@ -5496,7 +5815,8 @@ void QCPLineEnding::draw(QCPPainter *painter, const QCPVector2D &pos, double ang
 QCPAxisTicker::QCPAxisTicker() :
   mTickStepStrategy(tssReadability),
   mTickCount(5),
-  mTickOrigin(0)
+  mTickOrigin(0),
+  mRevision(0)
 {
 }
 
@@ -5512,6 +5832,7 @@ QCPAxisTicker::~QCPAxisTicker()
 void QCPAxisTicker::setTickStepStrategy(QCPAxisTicker::TickStepStrategy strategy)
 {
   mTickStepStrategy = strategy;
+  ++mRevision;
 }
 
 /*!
@@ -5528,6 +5849,7 @@ void QCPAxisTicker::setTickCount(int count)
     mTickCount = count;
   else
     qDebug() << Q_FUNC_INFO << "tick count must be greater than zero:" << count;
+  ++mRevision;
 }
 
 /*!
@@ -5541,6 +5863,7 @@ void QCPAxisTicker::setTickCount(int count)
 void QCPAxisTicker::setTickOrigin(double origin)
 {
   mTickOrigin = origin;
+  ++mRevision;
 }
 
 /*!
@@ -5915,6 +6238,7 @@ QCPAxisTickerDateTime::QCPAxisTickerDateTime() :
 void QCPAxisTickerDateTime::setDateTimeFormat(const QString &format)
 {
   mDateTimeFormat = format;
+  ++mRevision;
 }
 
 /*!
@@ -5930,6 +6254,7 @@ void QCPAxisTickerDateTime::setDateTimeFormat(const QString &format)
 void QCPAxisTickerDateTime::setDateTimeSpec(Qt::TimeSpec spec)
 {
   mDateTimeSpec = spec;
+  ++mRevision;
 }
 
 /*!
@@ -6252,6 +6577,7 @@ void QCPAxisTickerTime::setTimeFormat(const QString &format)
       mBiggestUnit = unit;
     }
   }
+  ++mRevision;
 }
 
 /*!
@@ -6264,6 +6590,7 @@ void QCPAxisTickerTime::setTimeFormat(const QString &format)
 void QCPAxisTickerTime::setFieldWidth(QCPAxisTickerTime::TimeUnit unit, int width)
 {
   mFieldWidth[unit] = qMax(width, 1);
+  ++mRevision;
 }
 
 /*! \internal
@@ -6447,6 +6774,7 @@ void QCPAxisTickerFixed::setTickStep(double step)
     mTickStep = step;
   else
     qDebug() << Q_FUNC_INFO << "tick step must be greater than zero:" << step;
+  ++mRevision;
 }
 
 /*!
@@ -6459,6 +6787,7 @@ void QCPAxisTickerFixed::setTickStep(double step)
 void QCPAxisTickerFixed::setScaleStrategy(QCPAxisTickerFixed::ScaleStrategy strategy)
 {
   mScaleStrategy = strategy;
+  ++mRevision;
 }
 
 /*! \internal
@@ -6533,6 +6862,9 @@ double QCPAxisTickerFixed::getTickStep(const QCPRange &range)
 
   You can access the map directly in order to add, remove or manipulate ticks, as an alternative to
   using the methods provided by QCPAxisTickerText, such as \ref setTicks and \ref addTick.
+  
+  Calling this method increments the \ref revision, so the axis regenerates its ticks on the next
+  replot. Don't keep the reference to modify the map after that replot.
 */
 
 /* end of documentation of inline functions */
@@ -6559,6 +6891,7 @@ QCPAxisTickerText::QCPAxisTickerText() :
 void QCPAxisTickerText::setTicks(const QMap<double, QString> &ticks)
 {
   mTicks = ticks;
+  ++mRevision;
 }
 
 /*! \overload
@@ -6586,6 +6919,7 @@ void QCPAxisTickerText::setSubTickCount(int subTicks)
     mSubTickCount = subTicks;
   else
     qDebug() << Q_FUNC_INFO << "sub tick count can't be negative:" << subTicks;
+  ++mRevision;
 }
 
 /*!
@@ -6599,6 +6933,7 @@ void QCPAxisTickerText::setSubTickCount(int subTicks)
 void QCPAxisTickerText::clear()
 {
   mTicks.clear();
+  ++mRevision;
 }
 
 /*!
@@ -6610,6 +6945,7 @@ void QCPAxisTickerText::clear()
 void QCPAxisTickerText::addTick(double position, const QString &label)
 {
   mTicks.insert(position, label);
+  ++mRevision;
 }
 
 /*! \overload
@@ -6625,6 +6961,7 @@ void QCPAxisTickerText::addTick(double position, const QString &label)
 void QCPAxisTickerText::addTicks(const QMap<double, QString> &ticks)
 {
   mTicks.unite(ticks);
+  ++mRevision;
 }
 
 /*! \overload
@@ -6645,6 +6982,7 @@ void QCPAxisTickerText::addTicks(const QVector<double> &positions, const QVector
   int n = qMin(positions.size(), labels.size());
   for (int i=0; i<n; ++i)
     mTicks.insert(positions.at(i), labels.at(i));
+  ++mRevision;
 }
 
 /*!
@@ -6757,6 +7095,7 @@ QCPAxisTickerPi::QCPAxisTickerPi() :
 void QCPAxisTickerPi::setPiSymbol(QString symbol)
 {
   mPiSymbol = symbol;
+  ++mRevision;
 }
 
 /*!
@@ -6768,6 +7107,7 @@ void QCPAxisTickerPi::setPiSymbol(QString symbol)
 void QCPAxisTickerPi::setPiValue(double pi)
 {
   mPiValue = pi;
+  ++mRevision;
 }
 
 /*!
@@ -6781,6 +7121,7 @@ void QCPAxisTickerPi::setPiValue(double pi)
 void QCPAxisTickerPi::setPeriodicity(int multiplesOfPi)
 {
   mPeriodicity = qAbs(multiplesOfPi);
+  ++mRevision;
 }
 
 /*!
@@ -6790,6 +7131,7 @@ void QCPAxisTickerPi::setPeriodicity(int multiplesOfPi)
 void QCPAxisTickerPi::setFractionStyle(QCPAxisTickerPi::FractionStyle style)
 {
   mFractionStyle = style;
+  ++mRevision;
 }
 
 /*! \internal
@@ -7047,6 +7389,7 @@ void QCPAxisTickerLog::setLogBase(double base)
     mLogBaseLnInv = 1.0/qLn(mLogBase);
   } else
     qDebug() << Q_FUNC_INFO << "log base has to be greater than zero:" << base;
+  ++mRevision;
 }
 
 /*!
@@ -7065,6 +7408,7 @@ void QCPAxisTickerLog::setSubTickCount(int subTicks)
     mSubTickCount = subTicks;
   else
     qDebug() << Q_FUNC_INFO << "sub tick count can't be negative:" << subTicks;
+  ++mRevision;
 }
 
 /*! \internal
@@ -7545,7 +7889,9 @@ QCPAxis::QCPAxis(QCPAxisRect *parent, AxisType type) :
   mAxisPainter(new QCPAxisPainterPrivate(parent->parentPlot())),
   mTicker(new QCPAxisTicker),
   mCachedMarginValid(false),
-  mCachedMargin(0)
+  mCachedMargin(0),
+  mTickVectorTicker(0),
+  mTickVectorRevision(0)
 {
   setParent(parent);
   mGrid->setVisible(false);
@@ -7876,8 +8222,10 @@ void QCPAxis::setRangeReversed(bool reversed)
 void QCPAxis::setTicker(QSharedPointer<QCPAxisTicker> ticker)
 {
   if (ticker)
+  {
     mTicker = ticker;
-  else
+    mTickVectorTicker = 0; // the previous ticker may have been deleted and the new one allocated at its address
+  } else
     qDebug() << Q_FUNC_INFO << "can not set 0 as axis ticker";
   // no need to invalidate margin cache here because produced tick labels are checked for changes in setupTickVector
 }
@@ -8935,7 +9283,7 @@ void QCPAxis::wheelEvent(QWheelEvent *event)
   const double wheelSteps = event->delta()/120.0; // a single step delta is +/-120 usually
   const double factor = qPow(mAxisRect->rangeZoomFactor(orientation()), wheelSteps);
   scaleRange(factor, pixelToCoord(orientation() == Qt::Horizontal ? event->pos().x() : event->pos().y()));
-  mParentPlot->replot();
+  mParentPlot->replot(QCustomPlot::rpQueuedReplot); // coalesces bursts of wheel events
 }
 
 /*! \internal
@@ -9019,12 +9367,27 @@ void QCPAxis::draw(QCPPainter *painter)
   
   If a change in the label text/count is detected, the cached axis margin is invalidated to make
   sure the next margin calculation recalculates the label sizes and returns an up-to-date value.
+  
+  The vectors are kept as they are if the range, the number format, the locale, the ticker and its
+  \ref QCPAxisTicker::revision are the same as in the previous call. So an axis whose range doesn't
+  change neither generates nor formats its ticks again, and its margin stays cached.
 */
 void QCPAxis::setupTickVectors()
 {
   if (!mParentPlot) return;
   if ((!mTicks && !mTickLabels && !mGrid->visible()) || mRange.size() <= 0) return;
   
+  // the ticks only depend on the range and the ticker, so skip generating and formatting them if
+  // neither changed since the last call:
+  QVector<double> state;
+  state << mRange.lower << mRange.upper << mNumberFormatChar.unicode() << mNumberPrecision << mSubTicks << mTickLabels;
+  if (mTicker.data() == mTickVectorTicker && mTicker->revision() == mTickVectorRevision && state == mTickVectorState && mParentPlot->locale() == mTickVectorLocale)
+    return;
+  mTickVectorTicker = mTicker.data();
+  mTickVectorRevision = mTicker->revision();
+  mTickVectorState = state;
+  mTickVectorLocale = mParentPlot->locale();
+  
   QVector<QString> oldLabels = mTickVectorLabels;
   mTicker->generate(mRange, mParentPlot->locale(), mNumberFormatChar, mNumberPrecision, mTickVector, mSubTicks ? &mSubTickVector : 0, mTickLabels ? &mTickVectorLabels : 0);
   mCachedMarginValid &= mTickVectorLabels == oldLabels; // if labels have changed, margin might have changed, too
@@ -9509,7 +9872,8 @@ void QCPAxisPainterPrivate::placeTickLabel(QCPPainter *painter, double position,
     case QCPAxis::atTop:    labelAnchor = QPointF(position, axisRect.top()-distanceToAxis-offset); break;
     case QCPAxis::atBottom: labelAnchor = QPointF(position, axisRect.bottom()+distanceToAxis+offset); break;
   }
-  if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && !painter->modes().testFlag(QCPPainter::pmNoCaching)) // label caching enabled
+  if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && !painter->modes().testFlag(QCPPainter::pmNoCaching) &&
+      QThread::currentThread() == mParentPlot->thread()) // label caching enabled, and not drawn by a threaded replot (pixmaps only work in the GUI thread)
   {
     CachedLabel *cachedLabel = mLabelCache.take(text); // attempt to get label from cache
     if (!cachedLabel)  // no cached label existed, create it
@@ -10299,6 +10663,108 @@ void QCPScatterStyle::drawShape(QCPPainter *painter, double x, double y) const
     }
   }
 }
+
+/*!
+  Draws the scatter shape with \a painter at each of the \a points. Points with NaN coordinates
+  are skipped.
+  
+  On raster paint devices (e.g. the paint buffers of QCustomPlot), the shape is rendered once with
+  the current pen, brush and antialiasing of \a painter into a sprite image, which is then drawn
+  at every point. This is much faster than drawing the shape's outline for every point, especially
+  with antialiasing. The sprites are placed at whole device pixels, so a shape may be offset by up
+  to half a pixel from where \ref drawShape would draw it. The sprites are kept in a cache that is
+  shared by all scatter styles and may be used from multiple threads.
+  
+  The shapes are drawn with \ref drawShape instead, if the painter is vectorized or in \ref
+  QCPPainter::pmNoCaching mode (exports and tiled replots), if its transform rotates or shears, if
+  the pen or brush isn't a solid color, and for \ref ssDot, \ref ssPixmap and \ref ssCustom.
+  
+  Like \ref drawShape, this function does not modify the pen or the brush on the painter, so \ref
+  applyTo should be called before.
+*/
+void QCPScatterStyle::drawShapes(QCPPainter *painter, const QVector<QPointF> &points) const
+{
+  QPointF center;
+  const QImage sprite = points.size() > 1 ? shapeSprite(painter, &center) : QImage();
+  if (sprite.isNull())
+  {
+    for (int i=0; i<points.size(); ++i)
+    {
+      if (!qIsNaN(points.at(i).x()) && !qIsNaN(points.at(i).y()))
+        drawShape(painter, points.at(i).x(), points.at(i).y());
+    }
+    return;
+  }
+  
+  // place the sprite at whole device pixels, so it is copied without resampling:
+  const QTransform deviceTransform = painter->deviceTransform();
+  const QTransform inverseTransform = deviceTransform.inverted();
+  const QSizeF spriteSize(sprite.width()/deviceTransform.m11(), sprite.height()/deviceTransform.m22());
+  for (int i=0; i<points.size(); ++i)
+  {
+    if (qIsNaN(points.at(i).x()) || qIsNaN(points.at(i).y()))
+      continue;
+    const QPointF devicePos = deviceTransform.map(points.at(i))-center;
+    painter->drawImage(QRectF(inverseTransform.map(QPointF(qRound(devicePos.x()), qRound(devicePos.y()))), spriteSize), sprite);
+  }
+}
+
+typedef QCache<QByteArray, QImage> QCPScatterSpriteCache;
+Q_GLOBAL_STATIC(QCPScatterSpriteCache, qcpScatterSprites)
+Q_GLOBAL_STATIC(QMutex, qcpScatterSpritesMutex)
+
+/*! \internal
+  
+  Returns the sprite used by \ref drawShapes, i.e. this scatter shape rendered with the current
+  pen, brush, antialiasing and device transform of \a painter, and sets \a center to the position
+  of the shape's center in the sprite (in pixels). Returns a null image if the shape can't be drawn
+  as sprite with \a painter.
+  
+  The shape's center is placed at the same sub-pixel offset that the transform of \a painter gives
+  to integer coordinates. The sprites are cached by all properties that influence their pixels.
+*/
+QImage QCPScatterStyle::shapeSprite(QCPPainter *painter, QPointF *center) const
+{
+  if (mShape == ssNone || mShape == ssDot || mShape == ssPixmap || mShape == ssCustom)
+    return QImage();
+  if (painter->modes().testFlag(QCPPainter::pmVectorized) || painter->modes().testFlag(QCPPainter::pmNoCaching) ||
+      !painter->paintEngine() || painter->paintEngine()->type() != QPaintEngine::Raster || painter->compositionMode() != QPainter::CompositionMode_SourceOver)
+    return QImage();
+  const QTransform deviceTransform = painter->deviceTransform();
+  if (deviceTransform.type() > QTransform::TxScale || deviceTransform.m11() <= 0 || !qFuzzyCompare(deviceTransform.m11(), deviceTransform.m22()))
+    return QImage();
+  const QPen pen = painter->pen();
+  const QBrush brush = painter->brush();
+  if (pen.brush().style() != Qt::SolidPattern || (brush.style() != Qt::NoBrush && brush.style() != Qt::SolidPattern))
+    return QImage();
+  
+  const double scale = deviceTransform.m11();
+  const QPointF offset(deviceTransform.dx()-qFloor(deviceTransform.dx()), deviceTransform.dy()-qFloor(deviceTransform.dy()));
+  // leave room for the pen width, sharp corners with miter joins and antialiasing:
+  const double penExtent = pen.isCosmetic() ? qMax(1.0, pen.widthF()) : pen.widthF()*scale;
+  const int halfSize = qCeil(mSize*0.5*scale+penExtent)+2;
+  *center = QPointF(halfSize, halfSize)+offset;
+  
+  QByteArray key;
+  QDataStream keyStream(&key, QIODevice::WriteOnly);
+  keyStream << int(mShape) << mSize << pen << brush << scale << offset << painter->antialiasing();
+  
+  QMutexLocker locker(qcpScatterSpritesMutex());
+  if (QImage *cachedSprite = qcpScatterSprites()->object(key))
+    return *cachedSprite;
+  QImage *sprite = new QImage(2*halfSize, 2*halfSize, QImage::Format_ARGB32_Premultiplied);
+  sprite->fill(Qt::transparent);
+  QCPPainter spritePainter(sprite);
+  spritePainter.setAntialiasing(painter->antialiasing());
+  spritePainter.setTransform(QTransform(scale, 0, 0, scale, center->x(), center->y())); // replaces the antialiasing shift, it is part of offset
+  spritePainter.setPen(pen);
+  spritePainter.setBrush(brush);
+  drawShape(&spritePainter, 0, 0);
+  spritePainter.end();
+  const QImage result = *sprite;
+  qcpScatterSprites()->insert(key, sprite);
+  return result;
+}
 /* end of 'src/scatterstyle.cpp' */
 
 //amalgamation: add datacontainer.cpp
@@ -12550,6 +13016,30 @@ QCP::Interaction QCPAbstractItem::selectionCategory() const
 /* including file 'src/core.cpp', size 126207                                */
 /* commit ce344b3f96a62e5f652585e55f1ae7c7883cd45b 2018-06-25 01:03:39 +0200 */
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPReplotProfile
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPReplotProfile
+  \brief Holds the timings of a single replot, recorded by the profiler of QCustomPlot
+  
+  If the profiler is enabled with \ref QCustomPlot::setProfilerFrames, every \ref
+  QCustomPlot::replot and \ref QCPLayer::replot records a profile. The recent profiles are
+  available via \ref QCustomPlot::replotProfiles and can be exported with \ref
+  QCustomPlot::saveProfilerTrace.
+  
+  \a start is the time in milliseconds since the construction of the QCustomPlot when the replot
+  started, \a duration the time it took. \a full is false if only buffered layers were redrawn,
+  i.e. for a \ref QCPLayer::replot or an incremental replot (\ref QCP::phIncrementalReplot).
+  
+  The \a entries hold the parts of the replot, see \ref EntryType. Their \a start is relative to
+  the start of the replot, also in milliseconds. For plottables, \a points is the number of data
+  points. \a thread numbers the threads which did the drawing in the order the profiler first saw
+  them, so with \ref QCustomPlot::setThreadedReplot or \ref QCustomPlot::setReplotTiles, entries
+  may overlap in time. A tiled layer records an entry for each layerable in each tile.
+*/
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCustomPlot
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -12880,11 +13370,24 @@ QCustomPlot::QCustomPlot(QWidget *parent) :
   mSelectionRectMode(QCP::srmNone),
   mSelectionRect(0),
   mOpenGl(false),
+  mThreadedReplot(false),
+  mReplotTiles(1),
+  mMaxFrameRate(0),
+  mProfilerFrames(0),
+  mProfilerOverlay(false),
   mMouseHasMoved(false),
   mMouseEventLayerable(0),
   mMouseSignalLayerable(0),
   mReplotting(false),
   mReplotQueued(false),
+  mLastReplotStart(-1),
+  mReplotTime(0),
+  mReplotTimeAverage(0),
+  mReplotIntervalAverage(0),
+  mDragDegraded(false),
+  mDragDegradedAABackup(QCP::aeNone),
+  mDragDegradedNotAABackup(QCP::aeNone),
+  mProfileStart(-1),
   mOpenGlMultisamples(16),
   mOpenGlAntialiasedElementsBackup(QCP::aeNone),
   mOpenGlCacheLabelsBackup(true)
@@ -12893,6 +13396,7 @@ QCustomPlot::QCustomPlot(QWidget *parent) :
   setAttribute(Qt::WA_OpaquePaintEvent);
   setFocusPolicy(Qt::ClickFocus);
   setMouseTracking(true);
+  mFrameTimer.start();
   QLocale currentLocale = locale();
   currentLocale.setNumberOptions(QLocale::OmitGroupSeparator);
   setLocale(currentLocale);
@@ -13363,6 +13867,139 @@ void QCustomPlot::setOpenGl(bool enabled, int multisampling)
 #endif
 }
 
+/*!
+  Sets whether \ref replot draws the layers into their paint buffers in parallel, using the global
+  QThreadPool.
+
+  Layers that share a paint buffer (see \ref QCPLayer::setMode) are always drawn one after another,
+  but different paint buffers are drawn at the same time. Layers in mode \ref QCPLayer::lmBuffered
+  have a paint buffer of their own and are drawn by pool threads. All other paint buffers, which
+  hold the background, grid, axes and legend in the default layer setup, are drawn by the calling
+  thread, so tick labels keep using the label cache (\ref QCP::phCacheLabels). Putting the
+  plottables on a buffered layer thus lets them be drawn in parallel to the axes, grid and legend.
+
+  This only spreads the drawing of one replot over several cores, it doesn't move it off the
+  calling thread: \ref replot still returns only once all paint buffers are finished, so the user
+  interface is blocked for the duration of the slowest paint buffer. In return, the plot and its
+  data may be modified freely between replots.
+
+  When enabled, the paint buffers are QImages (\ref QCPPaintBufferImage) instead of QPixmaps.
+  Layerables on buffered layers must not draw pixmaps (e.g. \ref QCPItemPixmap or pixmap scatter
+  styles), because pixmaps can't be used outside the GUI thread. Plottables that access each other
+  while drawing (e.g. graphs with a channel fill, \ref QCPGraph::setChannelFillGraph) must share a
+  paint buffer. If the platform can't render text outside the GUI thread
+  (QFontDatabase::supportsThreadedFontRendering), all paint buffers are drawn by the calling thread.
+
+  Threaded replots have no effect while OpenGL is used (\ref setOpenGl). By default they are
+  disabled.
+*/
+void QCustomPlot::setThreadedReplot(bool enabled)
+{
+  if (mThreadedReplot != enabled)
+  {
+    mThreadedReplot = enabled;
+    // recreate all paint buffers:
+    mPaintBuffers.clear();
+    setupPaintBuffers();
+  }
+}
+
+/*!
+  Sets the number of horizontal bands (tiles) into which the paint buffers of layers in \ref
+  QCPLayer::lmBuffered mode are divided. If \a tiles is larger than one, the paint buffers are
+  QImages (\ref QCPPaintBufferTiledImage) and each band of a buffered layer which has tiling enabled
+  (\ref QCPLayer::setTiled) is drawn by a separate thread of the global QThreadPool, which speeds up
+  software rendering of large plots or plots on high-DPI screens. A good value is usually
+  QThread::idealThreadCount. Layers are not tiled by default, so a typical setup moves the
+  plottables to a dedicated layer in \ref QCPLayer::lmBuffered mode and enables tiling for it.
+
+  Every band draws all layerables of the layer and lets the raster engine discard what is outside
+  the band, so the data to pixel transformation of the plottables is done once per band. Tiling
+  pays off when rasterization dominates, e.g. for antialiased lines, wide pens or filled graphs.
+
+  The layerables on tiled layers must be safe to draw concurrently, which excludes axes and items
+  because they update their tick positions and anchor positions while drawing. Caches are not
+  updated while drawing tiles, so for example \ref QCPGraph::setIncrementalDrawing has no effect
+  there. The first band is always drawn on the calling thread before the others are started, so
+  data that is computed lazily on the first draw is ready before the other threads need it.
+  Layerables that draw pixmaps should not be placed on tiled layers, because pixmaps can't be used
+  outside the GUI thread.
+
+  Tiles have no effect while OpenGL is used (\ref setOpenGl). The default is 1, i.e. no tiling.
+
+  \see setThreadedReplot
+*/
+void QCustomPlot::setReplotTiles(int tiles)
+{
+  tiles = qMax(1, tiles);
+  if (mReplotTiles != tiles)
+  {
+    mReplotTiles = tiles;
+    // recreate all paint buffers:
+    mPaintBuffers.clear();
+    setupPaintBuffers();
+  }
+}
+
+/*!
+  Limits the rate of queued replots (\ref replot with \ref rpQueuedReplot) to \a framesPerSecond.
+  A queued replot is deferred until at least <tt>1/framesPerSecond</tt> seconds have passed since
+  the start of the previous replot, and all replots queued in the meantime are coalesced into it.
+  So bursts of new data or mouse wheel events cause at most one replot per frame. A good value is
+  the refresh rate of the screen, e.g. <tt>QGuiApplication::primaryScreen()->refreshRate()</tt>.
+
+  The frame budget also enables a graceful degradation while the user drags: If the average replot
+  time (\ref replotTime) exceeds <tt>1/framesPerSecond</tt>, antialiasing is disabled for the
+  rest of the drag, as if \ref setNoAntialiasingOnDrag was enabled.
+
+  Replots with the priorities \ref rpImmediateRefresh and \ref rpRefreshHint are never delayed.
+  Setting \a framesPerSecond to 0 (the default) disables frame pacing, queued replots then happen
+  in the next event loop iteration.
+
+  \see frameRate
+*/
+void QCustomPlot::setMaxFrameRate(double framesPerSecond)
+{
+  mMaxFrameRate = qMax(0.0, framesPerSecond);
+}
+
+/*!
+  Enables the replot profiler and keeps the profiles of the last \a frames replots (see \ref
+  QCPReplotProfile). A profile holds the time it took to update the layout, to draw each layer and
+  to draw each layerable on it, as well as the number of data points of each plottable.
+
+  The profiles are available via \ref replotProfiles, can be shown on top of the plot with \ref
+  setProfilerOverlay and exported with \ref saveProfilerTrace.
+
+  Setting \a frames to 0 (the default) disables the profiler and discards the recorded profiles.
+  The profiler itself takes a few microseconds per layerable, so only enable it while measuring.
+*/
+void QCustomPlot::setProfilerFrames(int frames)
+{
+  mProfilerFrames = qMax(0, frames);
+  while (mReplotProfiles.size() > mProfilerFrames)
+    mReplotProfiles.removeFirst();
+}
+
+/*!
+  Sets whether a summary of the last replot profile is drawn in the top left corner of the plot.
+  It lists the replot time and frame rate, and the time spent in the layout, in each layer and in
+  each layerable, with the number of data points of plottables. Layerables of the same name (or
+  class, if they have no name) are summed up.
+
+  The overlay is painted on the widget and not into the paint buffers, so it doesn't appear in
+  exports (e.g. \ref savePng) and doesn't affect the measured times. It is only shown if the
+  profiler is enabled with \ref setProfilerFrames.
+*/
+void QCustomPlot::setProfilerOverlay(bool enabled)
+{
+  if (mProfilerOverlay != enabled)
+  {
+    mProfilerOverlay = enabled;
+    update();
+  }
+}
+
 /*!
   Sets the viewport of this QCustomPlot. Usually users of QCustomPlot don't need to change the
   viewport manually.
@@ -13799,30 +14436,119 @@ QList<QCPGraph*> QCustomPlot::selectedGraphs() const
 }
 
 /*!
-  Returns the item with \a index. If the index is invalid, returns 0.
-  
-  There is an overloaded version of this function with no parameter which returns the last added
-  item, see QCustomPlot::item()
-  
-  \see itemCount
+  Appends one data point with the common \a key to each of the first \a count graphs. The graph
+  with index \a i receives the value <tt>values[i]</tt>.
+
+  This is a convenience for streaming several series that are sampled at the same time, so a new
+  sample is added with one call instead of one \ref QCPGraph::addData call per graph. The values
+  can be passed from an array on the stack, so adding a sample doesn't allocate memory apart from
+  the growth of the data containers. To append many samples at once, use the overload taking a
+  vector of keys.
+
+  \see graph, graphCount
 */
-QCPAbstractItem *QCustomPlot::item(int index) const
+void QCustomPlot::addGraphData(double key, const double *values, int count)
 {
-  if (index >= 0 && index < mItems.size())
-  {
-    return mItems.at(index);
-  } else
-  {
-    qDebug() << Q_FUNC_INFO << "index out of bounds:" << index;
-    return 0;
-  }
+  addGraphRows(&key, 1, values, count, true);
 }
 
 /*! \overload
-  
-  Returns the last item that was added to this plot. If there are no items in the plot,
-  returns 0.
-  
+
+  Appends a batch of samples to the first \e n graphs, where \e n is <tt>values.size()/keys.size()</tt>.
+  The \a values are stored row by row, one row of \e n values per key, so the value of the graph
+  with index \e i for the key at index \e k is <tt>values.at(k*n+i)</tt>.
+
+  The keys are checked for their sort order only once for all graphs, and each graph receives its
+  part of the batch with a single call to \ref QCPDataContainer::add, so the container grows once
+  per batch instead of once per sample. If you can guarantee that the \a keys are sorted
+  ascendingly, set \a alreadySorted to true to skip the check.
+
+  \see graph, graphCount
+*/
+void QCustomPlot::addGraphData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted)
+{
+  addGraphRows(keys.constData(), keys.size(), values.constData(), values.size(), alreadySorted);
+}
+
+/*! \internal
+
+  Appends the \a keyCount rows of \a values to the first graphs, for both overloads of \ref
+  addGraphData. \a valueCount must be a multiple of \a keyCount, each row holds one value per
+  graph.
+
+  A single row is appended with one \ref QCPDataContainer::add call per graph, which takes
+  constant time when the key is larger than the existing ones. Larger batches are sorted once and
+  added to each graph at once.
+*/
+void QCustomPlot::addGraphRows(const double *keys, int keyCount, const double *values, int valueCount, bool alreadySorted)
+{
+  if (keyCount <= 0)
+    return;
+  const int n = valueCount/keyCount;
+  if (valueCount != n*keyCount || n > mGraphs.size())
+  {
+    qDebug() << Q_FUNC_INFO << "values don't form one row per key for the existing graphs:" << keyCount << valueCount << mGraphs.size();
+    return;
+  }
+  
+  if (keyCount == 1)
+  {
+    for (int i=0; i<n; ++i)
+      mGraphs.at(i)->data()->add(QCPGraphData(keys[0], values[i]));
+    return;
+  }
+  
+  if (!alreadySorted)
+  {
+    alreadySorted = true;
+    for (int k=1; k<keyCount; ++k)
+    {
+      if (keys[k] < keys[k-1])
+      {
+        alreadySorted = false;
+        break;
+      }
+    }
+  }
+  
+  QVector<QCPGraphData> tempData(keyCount); // reused for all graphs
+  for (int i=0; i<n; ++i)
+  {
+    const double *value = values+i;
+    for (int k=0; k<keyCount; ++k, value += n)
+    {
+      tempData[k].key = keys[k];
+      tempData[k].value = *value;
+    }
+    mGraphs.at(i)->data()->add(tempData, alreadySorted);
+  }
+}
+
+/*!
+  Returns the item with \a index. If the index is invalid, returns 0.
+  
+  There is an overloaded version of this function with no parameter which returns the last added
+  item, see QCustomPlot::item()
+  
+  \see itemCount
+*/
+QCPAbstractItem *QCustomPlot::item(int index) const
+{
+  if (index >= 0 && index < mItems.size())
+  {
+    return mItems.at(index);
+  } else
+  {
+    qDebug() << Q_FUNC_INFO << "index out of bounds:" << index;
+    return 0;
+  }
+}
+
+/*! \overload
+  
+  Returns the last item that was added to this plot. If there are no items in the plot,
+  returns 0.
+  
   \see itemCount
 */
 QCPAbstractItem *QCustomPlot::item() const
@@ -14393,6 +15119,7 @@ void QCustomPlot::deselectAll()
     foreach (QCPLayerable *layerable, layer->children())
       layerable->deselectEvent(0);
   }
+  invalidatePaintBuffers();
 }
 
 /*!
@@ -14419,6 +15146,21 @@ void QCustomPlot::deselectAll()
   If a layer is in mode \ref QCPLayer::lmBuffered (\ref QCPLayer::setMode), it is also possible to
   replot only that specific layer via \ref QCPLayer::replot. See the documentation there for
   details.
+
+  If a maximum frame rate is set (\ref setMaxFrameRate), queued replots are additionally deferred
+  until the frame interval has passed since the start of the previous replot. The time a replot
+  took is available via \ref replotTime, a breakdown of it is recorded by the profiler (\ref
+  setProfilerFrames).
+
+  If the plotting hint \ref QCP::phIncrementalReplot is set (\ref setPlottingHints), this method
+  decides by itself whether a partial replot is sufficient: As long as the viewport and the ranges,
+  scale types and visibility of all axes are unchanged since the last full replot, the layout isn't
+  updated and only the layers in mode \ref QCPLayer::lmBuffered are redrawn. The paint buffers of
+  all other layers (typically background, grid, axes and legend) are reused. So if for example the
+  plottables are placed on a buffered layer, appending data and calling replot only redraws the
+  plottables. Changes to the appearance of objects on the other layers (e.g. new axis labels or
+  pens) are not detected; call \ref invalidatePaintBuffers after such changes to make the next
+  replot a full one.
 */
 void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
 {
@@ -14427,7 +15169,10 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
     if (!mReplotQueued)
     {
       mReplotQueued = true;
-      QTimer::singleShot(0, this, SLOT(replot()));
+      int delay = 0;
+      if (mMaxFrameRate > 0 && mLastReplotStart >= 0) // pace queued replots to the maximum frame rate
+        delay = qMax(0, qCeil((mLastReplotStart+1e9/mMaxFrameRate-mFrameTimer.nsecsElapsed())*1e-6));
+      QTimer::singleShot(delay, this, SLOT(replot()));
     }
     return;
   }
@@ -14436,25 +15181,131 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
     return;
   mReplotting = true;
   mReplotQueued = false;
+  const qint64 replotStart = mFrameTimer.nsecsElapsed();
   emit beforeReplot();
   
-  updateLayout();
-  // draw all layered objects (grid, axes, plottables, items, legend,...) into their buffers:
-  setupPaintBuffers();
-  foreach (QCPLayer *layer, mLayers)
-    layer->drawToPaintBuffer();
-  for (int i=0; i<mPaintBuffers.size(); ++i)
-    mPaintBuffers.at(i)->setInvalidated(false);
+  beginProfile();
+  const QVector<double> state = replotState();
+  const bool incremental = mPlottingHints.testFlag(QCP::phIncrementalReplot) && state == mReplotState && !mPaintBuffers.isEmpty() && !hasInvalidatedPaintBuffers();
+  if (incremental)
+  {
+    // layout and ranges are unchanged, so only the layers with a dedicated paint buffer need redrawing:
+    QList<QCPLayer*> bufferedLayers;
+    foreach (QCPLayer *layer, mLayers)
+    {
+      if (layer->mode() == QCPLayer::lmBuffered && !layer->mPaintBuffer.isNull())
+      {
+        layer->mPaintBuffer.data()->clear(Qt::transparent);
+        bufferedLayers.append(layer);
+      }
+    }
+    drawLayers(bufferedLayers);
+  } else
+  {
+    const qint64 layoutStart = mFrameTimer.nsecsElapsed();
+    updateLayout();
+    if (mProfileStart >= 0)
+      addProfileEntry(QCPReplotProfile::etLayout, QLatin1String("layout"), layoutStart);
+    // draw all layered objects (grid, axes, plottables, items, legend,...) into their buffers:
+    setupPaintBuffers();
+    drawLayers(mLayers);
+    for (int i=0; i<mPaintBuffers.size(); ++i)
+      mPaintBuffers.at(i)->setInvalidated(false);
+    mReplotState = state;
+  }
+  endProfile(!incremental);
   
   if ((refreshPriority == rpRefreshHint && mPlottingHints.testFlag(QCP::phImmediateRefresh)) || refreshPriority==rpImmediateRefresh)
     repaint();
   else
     update();
   
+  // update frame statistics, averages are exponential moving averages:
+  mReplotTime = (mFrameTimer.nsecsElapsed()-replotStart)*1e-6;
+  mReplotTimeAverage = mReplotTimeAverage > 0 ? 0.9*mReplotTimeAverage+0.1*mReplotTime : mReplotTime;
+  if (mLastReplotStart >= 0)
+  {
+    const double interval = (replotStart-mLastReplotStart)*1e-6;
+    mReplotIntervalAverage = mReplotIntervalAverage > 0 ? 0.9*mReplotIntervalAverage+0.1*interval : interval;
+  }
+  mLastReplotStart = replotStart;
+  
   emit afterReplot();
   mReplotting = false;
 }
 
+/*!
+  Returns the time in milliseconds that the last \ref replot took. If \a average is true, returns
+  an exponential moving average over the recent replots instead.
+
+  The time covers updating the layout and drawing into the paint buffers, and with \ref
+  rpImmediateRefresh also painting the widget. With other refresh priorities the widget is painted
+  later by the event loop, which isn't included.
+
+  \see frameRate, setMaxFrameRate
+*/
+double QCustomPlot::replotTime(bool average) const
+{
+  return average ? mReplotTimeAverage : mReplotTime;
+}
+
+/*!
+  Returns the recent number of replots per second, derived from an exponential moving average of
+  the intervals between the starts of successive replots. Returns 0 before the second replot.
+
+  \see replotTime, setMaxFrameRate
+*/
+double QCustomPlot::frameRate() const
+{
+  return mReplotIntervalAverage > 0 ? 1000.0/mReplotIntervalAverage : 0;
+}
+
+/*!
+  Saves the replot profiles recorded by the profiler (\ref setProfilerFrames) to \a fileName in
+  the trace event format of Chromium, which can be opened with \c chrome://tracing or the Perfetto
+  UI. Each replot is a slice on thread 0 (the thread of the widget), containing the slices of the
+  layout, the layers and the layerables on the threads which drew them. The number of data points
+  of plottables is stored in the arguments of their slices.
+
+  Returns true on success, false if no profiles were recorded or the file couldn't be written.
+
+  \see replotProfiles
+*/
+bool QCustomPlot::saveProfilerTrace(const QString &fileName) const
+{
+  if (mReplotProfiles.isEmpty())
+  {
+    qDebug() << Q_FUNC_INFO << "no replot profiles recorded, see setProfilerFrames";
+    return false;
+  }
+  
+  // timestamps and durations of trace events are in microseconds:
+  const QString eventFormat = QLatin1String("{\"name\":\"%1\",\"cat\":\"%2\",\"ph\":\"X\",\"pid\":1,\"tid\":%3,\"ts\":%4,\"dur\":%5,\"args\":{\"points\":%6}}");
+  QStringList events;
+  foreach (const QCPReplotProfile &profile, mReplotProfiles)
+  {
+    events << eventFormat.arg(profile.full ? QLatin1String("replot") : QLatin1String("partial replot"), QLatin1String("replot"), QLatin1String("0"),
+                              QString::number(profile.start*1000.0, 'f', 3), QString::number(profile.duration*1000.0, 'f', 3), QLatin1String("0"));
+    foreach (const QCPReplotProfile::Entry &entry, profile.entries)
+    {
+      QString name = entry.name;
+      name.replace(QLatin1Char('\\'), QLatin1String("\\\\")).replace(QLatin1Char('"'), QLatin1String("\\\""));
+      const QString category = entry.type == QCPReplotProfile::etLayout ? QLatin1String("layout") : entry.type == QCPReplotProfile::etLayer ? QLatin1String("layer") : QLatin1String("layerable");
+      events << eventFormat.arg(name, category, QString::number(entry.thread),
+                                QString::number((profile.start+entry.start)*1000.0, 'f', 3), QString::number(entry.duration*1000.0, 'f', 3), QString::number(entry.points));
+    }
+  }
+  
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    qDebug() << Q_FUNC_INFO << "failed to open file" << fileName << file.errorString();
+    return false;
+  }
+  const QByteArray trace = "{\"traceEvents\":[\n" + events.join(QLatin1String(",\n")).toUtf8() + "\n]}\n";
+  return file.write(trace) == trace.size();
+}
+
 /*!
   Rescales the axes such that all plottables (like graphs) in the plot are fully visible.
   
@@ -14754,6 +15605,8 @@ void QCustomPlot::paintEvent(QPaintEvent *event)
     drawBackground(&painter);
     for (int bufferIndex = 0; bufferIndex < mPaintBuffers.size(); ++bufferIndex)
       mPaintBuffers.at(bufferIndex)->draw(&painter);
+    if (mProfilerOverlay && !mReplotProfiles.isEmpty())
+      drawProfilerOverlay(&painter);
   }
 }
 
@@ -14888,6 +15741,16 @@ void QCustomPlot::mouseMoveEvent(QMouseEvent *event)
   if (!mMouseHasMoved && (mMousePressPos-event->pos()).manhattanLength() > 3)
     mMouseHasMoved = true; // moved too far from mouse press position, don't handle as click on mouse release
   
+  // keep dragging responsive if replots don't fit into the frame budget (see setMaxFrameRate):
+  if (!mDragDegraded && !mNoAntialiasingOnDrag && mMaxFrameRate > 0 && mMouseEventLayerable && (event->buttons() & Qt::LeftButton) &&
+      mReplotTimeAverage > 1000.0/mMaxFrameRate)
+  {
+    mDragDegraded = true;
+    mDragDegradedAABackup = mAntialiasedElements;
+    mDragDegradedNotAABackup = mNotAntialiasedElements;
+    setNotAntialiasedElements(QCP::aeAll);
+  }
+  
   if (mSelectionRect && mSelectionRect->isActive())
     mSelectionRect->moveSelection(event);
   else if (mMouseEventLayerable) // call event of affected layerable:
@@ -14953,8 +15816,18 @@ void QCustomPlot::mouseReleaseEvent(QMouseEvent *event)
     }
   }
   
-  if (noAntialiasingOnDrag())
+  if (mDragDegraded)
+  {
+    setAntialiasedElements(mDragDegradedAABackup);
+    setNotAntialiasedElements(mDragDegradedNotAABackup);
+    mDragDegraded = false;
+    invalidatePaintBuffers(); // antialiasing changed while the ranges may be unchanged
+    replot(rpQueuedReplot);
+  } else if (noAntialiasingOnDrag())
+  {
+    invalidatePaintBuffers();
     replot(rpQueuedReplot);
+  }
   
   event->accept(); // in case QCPLayerable reimplementation manipulates event accepted state. In QWidget event system, QCustomPlot wants to accept the event.
 }
@@ -15128,9 +16001,10 @@ void QCustomPlot::setupPaintBuffers()
 
   This method is used by \ref setupPaintBuffers when it needs to create new paint buffers.
 
-  Depending on the current setting of \ref setOpenGl, and the current Qt version, different
-  backends (subclasses of \ref QCPAbstractPaintBuffer) are created, initialized with the proper
-  size and device pixel ratio, and returned.
+  Depending on the current setting of \ref setOpenGl, \ref setReplotTiles and \ref
+  setThreadedReplot, and the current Qt version, different backends (subclasses of \ref
+  QCPAbstractPaintBuffer) are created, initialized with the proper size and device pixel ratio, and
+  returned.
 */
 QCPAbstractPaintBuffer *QCustomPlot::createPaintBuffer()
 {
@@ -15144,10 +16018,99 @@ QCPAbstractPaintBuffer *QCustomPlot::createPaintBuffer()
     qDebug() << Q_FUNC_INFO << "OpenGL enabled even though no support for it compiled in, this shouldn't have happened. Falling back to pixmap paint buffer.";
     return new QCPPaintBufferPixmap(viewport().size(), mBufferDevicePixelRatio);
 #endif
-  } else
+  } else if (mReplotTiles > 1)
+    return new QCPPaintBufferTiledImage(viewport().size(), mBufferDevicePixelRatio, mReplotTiles);
+  else if (mThreadedReplot)
+    return new QCPPaintBufferImage(viewport().size(), mBufferDevicePixelRatio);
+  else
     return new QCPPaintBufferPixmap(viewport().size(), mBufferDevicePixelRatio);
 }
 
+/*! \internal
+
+  Draws a group of layers that share a paint buffer for \ref drawLayers on a pool thread.
+*/
+class QCustomPlot::LayerGroupTask : public QRunnable
+{
+public:
+  LayerGroupTask(const QList<QCPLayer*> &layers, QSemaphore *finished) : mLayers(layers), mFinished(finished) {}
+  virtual void run() Q_DECL_OVERRIDE
+  {
+    QCustomPlot::drawLayerGroup(mLayers);
+    mFinished->release();
+  }
+  
+private:
+  QList<QCPLayer*> mLayers;
+  QSemaphore *mFinished;
+};
+
+/*! \internal
+
+  Draws the \a layers into their associated paint buffers (see \ref setupPaintBuffers). The layers
+  must be in ascending order of their index.
+
+  If \ref setThreadedReplot is enabled, the groups of layers that share a paint buffer are drawn in
+  parallel, and this method returns when all of them are finished. Groups of a layer in mode \ref
+  QCPLayer::lmBuffered are drawn by the global QThreadPool, the other groups and those for which
+  the pool has no free thread are drawn by the calling thread.
+*/
+void QCustomPlot::drawLayers(const QList<QCPLayer*> &layers)
+{
+  QList<QList<QCPLayer*> > groups;
+  QCPAbstractPaintBuffer *groupBuffer = 0;
+  foreach (QCPLayer *layer, layers)
+  {
+    if (groups.isEmpty() || layer->mPaintBuffer.data() != groupBuffer)
+    {
+      groups.append(QList<QCPLayer*>());
+      groupBuffer = layer->mPaintBuffer.data();
+    }
+    groups.last().append(layer);
+  }
+  
+  if (!mThreadedReplot || mOpenGl || groups.size() < 2 || !QFontDatabase::supportsThreadedFontRendering())
+  {
+    foreach (const QList<QCPLayer*> &group, groups)
+      drawLayerGroup(group);
+    return;
+  }
+  
+  // buffered layers (typically plottables) go to the pool, the axes, grid and legend stay on this
+  // thread, where their tick labels may be cached:
+  QSemaphore finished;
+  int started = 0;
+  QList<QList<QCPLayer*> > ownGroups;
+  foreach (const QList<QCPLayer*> &group, groups)
+  {
+    if (group.first()->mode() == QCPLayer::lmBuffered)
+    {
+      LayerGroupTask *task = new LayerGroupTask(group, &finished);
+      if (QThreadPool::globalInstance()->tryStart(task))
+      {
+        ++started;
+        continue;
+      }
+      delete task;
+    }
+    ownGroups.append(group);
+  }
+  foreach (const QList<QCPLayer*> &group, ownGroups)
+    drawLayerGroup(group);
+  finished.acquire(started);
+}
+
+/*! \internal
+
+  Draws the \a layers, which share a paint buffer, one after another into it. Used by \ref
+  drawLayers.
+*/
+void QCustomPlot::drawLayerGroup(const QList<QCPLayer*> &layers)
+{
+  foreach (QCPLayer *layer, layers)
+    layer->drawToPaintBuffer();
+}
+
 /*!
   This method returns whether any of the paint buffers held by this QCustomPlot instance are
   invalidated.
@@ -15169,6 +16132,156 @@ bool QCustomPlot::hasInvalidatedPaintBuffers()
   return false;
 }
 
+/*!
+  Marks all paint buffers as invalidated, so the next call to \ref replot redraws all layers, even
+  if the plotting hint \ref QCP::phIncrementalReplot is set and the axis ranges haven't changed.
+
+  Also until the next full replot, \ref QCPLayer::replot replots the whole plot instead of the
+  single layer.
+
+  \see hasInvalidatedPaintBuffers
+*/
+void QCustomPlot::invalidatePaintBuffers()
+{
+  for (int i=0; i<mPaintBuffers.size(); ++i)
+    mPaintBuffers.at(i)->setInvalidated();
+}
+
+/*! \internal
+
+  Returns the properties the layout and the drawing of axes, grids and legends mostly depend on:
+  the viewport, the buffer device pixel ratio, and range, scale type, range reversal and visibility
+  of every axis. \ref replot compares them to the ones of the last full replot if the plotting hint
+  \ref QCP::phIncrementalReplot is set.
+*/
+QVector<double> QCustomPlot::replotState() const
+{
+  QVector<double> state;
+  state << mViewport.x() << mViewport.y() << mViewport.width() << mViewport.height() << mBufferDevicePixelRatio;
+  foreach (QCPAxisRect *rect, axisRects())
+  {
+    foreach (QCPAxis *axis, rect->axes())
+      state << axis->range().lower << axis->range().upper << axis->scaleType() << axis->rangeReversed() << axis->visible();
+  }
+  return state;
+}
+
+/*! \internal
+
+  Starts recording a replot profile if the profiler is enabled (\ref setProfilerFrames) and no
+  profile is being recorded yet. Must be called on the thread of the widget.
+
+  \see endProfile, addProfileEntry
+*/
+void QCustomPlot::beginProfile()
+{
+  if (mProfilerFrames > 0 && mProfileStart < 0)
+  {
+    if (mProfileThreads.isEmpty()) // the thread of the widget is always thread 0
+      mProfileThreads.append(QThread::currentThreadId());
+    mProfileStart = mFrameTimer.nsecsElapsed();
+  }
+}
+
+/*! \internal
+
+  Finishes the profile started by \ref beginProfile and appends it to the recorded profiles,
+  discarding the oldest one if there are more than \ref setProfilerFrames. \a full tells whether
+  all layers were redrawn.
+*/
+void QCustomPlot::endProfile(bool full)
+{
+  if (mProfileStart < 0)
+    return;
+  mCurrentProfile.start = mProfileStart*1e-6;
+  mCurrentProfile.duration = (mFrameTimer.nsecsElapsed()-mProfileStart)*1e-6;
+  mCurrentProfile.full = full;
+  mReplotProfiles.append(mCurrentProfile);
+  while (mReplotProfiles.size() > mProfilerFrames)
+    mReplotProfiles.removeFirst();
+  mCurrentProfile = QCPReplotProfile();
+  mProfileStart = -1;
+}
+
+/*! \internal
+
+  Adds an entry to the profile being recorded, which lasts from \a start (in nanoseconds of
+  mFrameTimer) until now. Only call this while a profile is recorded (mProfileStart isn't
+  negative). It may be called from the pool threads that draw layers concurrently.
+*/
+void QCustomPlot::addProfileEntry(QCPReplotProfile::EntryType type, const QString &name, qint64 start, int points)
+{
+  QCPReplotProfile::Entry entry;
+  entry.type = type;
+  entry.name = name;
+  entry.start = (start-mProfileStart)*1e-6;
+  entry.duration = (mFrameTimer.nsecsElapsed()-start)*1e-6;
+  entry.points = points;
+  
+  QMutexLocker locker(&mProfileMutex);
+  entry.thread = mProfileThreads.indexOf(QThread::currentThreadId());
+  if (entry.thread < 0)
+  {
+    entry.thread = mProfileThreads.size();
+    mProfileThreads.append(QThread::currentThreadId());
+  }
+  mCurrentProfile.entries.append(entry);
+}
+
+/*! \internal
+
+  Draws the summary of the last replot profile in the top left corner of the viewport, see \ref
+  setProfilerOverlay.
+*/
+void QCustomPlot::drawProfilerOverlay(QCPPainter *painter)
+{
+  const QCPReplotProfile &profile = mReplotProfiles.last();
+  // sum up entries of the same name, several tiles or layerables of the same class add up:
+  QStringList layerNames, layerableNames;
+  QHash<QString, double> durations;
+  QHash<QString, int> points;
+  foreach (const QCPReplotProfile::Entry &entry, profile.entries)
+  {
+    const QString name = entry.type == QCPReplotProfile::etLayer ? QLatin1String("layer ")+entry.name : entry.name;
+    if (!durations.contains(name))
+      (entry.type == QCPReplotProfile::etLayerable ? layerableNames : layerNames).append(name);
+    durations[name] += entry.duration;
+    points[name] = qMax(points.value(name), entry.points);
+  }
+  
+  QStringList labels, values;
+  labels << (profile.full ? QLatin1String("replot") : QLatin1String("partial replot"));
+  values << QString(QLatin1String("%1 ms (average %2 ms), %3 fps")).arg(profile.duration, 0, 'f', 2).arg(mReplotTimeAverage, 0, 'f', 2).arg(frameRate(), 0, 'f', 1);
+  foreach (const QString &name, layerNames+layerableNames)
+  {
+    QString value = QString::number(durations.value(name), 'f', 2)+QLatin1String(" ms");
+    if (points.value(name) > 0)
+      value += QString(QLatin1String(", %1 points")).arg(points.value(name));
+    labels << name;
+    values << value;
+  }
+  
+  const QString labelText = labels.join(QLatin1String("\n"));
+  const QString valueText = values.join(QLatin1String("\n"));
+  const QFontMetrics metrics(font());
+  const QRect labelBounds = metrics.boundingRect(QRect(), Qt::AlignLeft|Qt::AlignTop, labelText);
+  const QRect valueBounds = metrics.boundingRect(QRect(), Qt::AlignRight|Qt::AlignTop, valueText);
+  const int padding = 4;
+  const QRect box(mViewport.topLeft()+QPoint(padding, padding),
+                  QSize(labelBounds.width()+valueBounds.width()+4*padding, qMax(labelBounds.height(), valueBounds.height())+2*padding));
+  const QRect textRect = box.adjusted(padding, padding, -padding, -padding);
+  
+  painter->save();
+  painter->setFont(font());
+  painter->setPen(QPen(QColor(0, 0, 0, 100)));
+  painter->setBrush(QBrush(QColor(255, 255, 255, 220)));
+  painter->drawRect(box);
+  painter->setPen(QPen(Qt::black));
+  painter->drawText(textRect, Qt::AlignLeft|Qt::AlignTop, labelText);
+  painter->drawText(textRect, Qt::AlignRight|Qt::AlignTop, valueText);
+  painter->restore();
+}
+
 /*! \internal
 
   When \ref setOpenGl is set to true, this method is used to initialize OpenGL (create a context,
@@ -15365,6 +16478,7 @@ void QCustomPlot::processRectSelection(QRect rect, QMouseEvent *event)
   if (selectionStateChanged)
   {
     emit selectionChangedByUser();
+    invalidatePaintBuffers(); // selected axes and legend items change their appearance
     replot(rpQueuedReplot);
   } else if (mSelectionRect)
     mSelectionRect->layer()->replot();
@@ -15442,6 +16556,7 @@ void QCustomPlot::processPointSelection(QMouseEvent *event)
   if (selectionStateChanged)
   {
     emit selectionChangedByUser();
+    invalidatePaintBuffers(); // selected axes and legend items change their appearance
     replot(rpQueuedReplot);
   }
 }
@@ -15906,6 +17021,10 @@ void QCPColorGradient::setPeriodic(bool enabled)
   mPeriodic = enabled;
 }
 
+namespace QCPSimd {
+static void colorizeLinear(const double *data, int stride, int count, double lower, double posToIndexFactor, const QRgb *colors, int levelCount, QRgb *out); // defined in the QCPSimd section
+}
+
 /*! \overload
   
   This method is used to quickly convert a \a data array to colors. The colors will be output in
@@ -15923,6 +17042,8 @@ void QCPColorGradient::setPeriodic(bool enabled)
 
   The QRgb values that are placed in \a scanLine have their r, g and b components premultiplied
   with alpha (see QImage::Format_ARGB32_Premultiplied).
+
+  Linear, non-periodic mappings are computed by a vectorized kernel, see \ref QCPSimd.
 */
 void QCPColorGradient::colorize(const double *data, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor, bool logarithmic)
 {
@@ -15953,24 +17074,15 @@ void QCPColorGradient::colorize(const double *data, const QCPRange &range, QRgb
         scanLine[i] = mColorBuffer.at(index);
       }
     } else
-    {
-      for (int i=0; i<n; ++i)
-      {
-        int index = (data[dataIndexFactor*i]-range.lower)*posToIndexFactor;
-        if (index < 0)
-          index = 0;
-        else if (index >= mLevelCount)
-          index = mLevelCount-1;
-        scanLine[i] = mColorBuffer.at(index);
-      }
-    }
+      QCPSimd::colorizeLinear(data, dataIndexFactor, n, range.lower, posToIndexFactor, mColorBuffer.constData(), mLevelCount, scanLine);
   } else // logarithmic == true
   {
+    const double logRangeSize = qLn(range.upper/range.lower);
     if (mPeriodic)
     {
       for (int i=0; i<n; ++i)
       {
-        int index = (int)(qLn(data[dataIndexFactor*i]/range.lower)/qLn(range.upper/range.lower)*(mLevelCount-1)) % mLevelCount;
+        int index = (int)(qLn(data[dataIndexFactor*i]/range.lower)/logRangeSize*(mLevelCount-1)) % mLevelCount;
         if (index < 0)
           index += mLevelCount;
         scanLine[i] = mColorBuffer.at(index);
@@ -15979,7 +17091,7 @@ void QCPColorGradient::colorize(const double *data, const QCPRange &range, QRgb
     {
       for (int i=0; i<n; ++i)
       {
-        int index = qLn(data[dataIndexFactor*i]/range.lower)/qLn(range.upper/range.lower)*(mLevelCount-1);
+        int index = qLn(data[dataIndexFactor*i]/range.lower)/logRangeSize*(mLevelCount-1);
         if (index < 0)
           index = 0;
         else if (index >= mLevelCount)
@@ -16041,19 +17153,12 @@ void QCPColorGradient::colorize(const double *data, const unsigned char *alpha,
       }
     } else
     {
+      QCPSimd::colorizeLinear(data, dataIndexFactor, n, range.lower, posToIndexFactor, mColorBuffer.constData(), mLevelCount, scanLine);
       for (int i=0; i<n; ++i)
       {
-        int index = (data[dataIndexFactor*i]-range.lower)*posToIndexFactor;
-        if (index < 0)
-          index = 0;
-        else if (index >= mLevelCount)
-          index = mLevelCount-1;
-        if (alpha[dataIndexFactor*i] == 255)
-        {
-          scanLine[i] = mColorBuffer.at(index);
-        } else
+        if (alpha[dataIndexFactor*i] != 255)
         {
-          const QRgb rgb = mColorBuffer.at(index);
+          const QRgb rgb = scanLine[i];
           const float alphaF = alpha[dataIndexFactor*i]/255.0f;
           scanLine[i] = qRgba(qRed(rgb)*alphaF, qGreen(rgb)*alphaF, qBlue(rgb)*alphaF, qAlpha(rgb)*alphaF);
         }
@@ -16061,11 +17166,12 @@ void QCPColorGradient::colorize(const double *data, const unsigned char *alpha,
     }
   } else // logarithmic == true
   {
+    const double logRangeSize = qLn(range.upper/range.lower);
     if (mPeriodic)
     {
       for (int i=0; i<n; ++i)
       {
-        int index = (int)(qLn(data[dataIndexFactor*i]/range.lower)/qLn(range.upper/range.lower)*(mLevelCount-1)) % mLevelCount;
+        int index = (int)(qLn(data[dataIndexFactor*i]/range.lower)/logRangeSize*(mLevelCount-1)) % mLevelCount;
         if (index < 0)
           index += mLevelCount;
         if (alpha[dataIndexFactor*i] == 255)
@@ -16082,7 +17188,7 @@ void QCPColorGradient::colorize(const double *data, const unsigned char *alpha,
     {
       for (int i=0; i<n; ++i)
       {
-        int index = qLn(data[dataIndexFactor*i]/range.lower)/qLn(range.upper/range.lower)*(mLevelCount-1);
+        int index = qLn(data[dataIndexFactor*i]/range.lower)/logRangeSize*(mLevelCount-1);
         if (index < 0)
           index = 0;
         else if (index >= mLevelCount)
@@ -17951,7 +19057,7 @@ void QCPAxisRect::wheelEvent(QWheelEvent *event)
             mRangeZoomVertAxis.at(i)->scaleRange(factor, mRangeZoomVertAxis.at(i)->pixelToCoord(event->pos().y()));
         }
       }
-      mParentPlot->replot();
+      mParentPlot->replot(QCustomPlot::rpQueuedReplot); // coalesces bursts of wheel events
     }
   }
 }
@@ -19947,24 +21053,386 @@ void QCPColorScaleAxisRectPrivate::axisSelectableChanged(QCPAxis::SelectablePart
 /* end of 'src/layoutelements/layoutelement-colorscale.cpp' */
 
 
-/* including file 'src/plottables/plottable-graph.cpp', size 74194           */
-/* commit ce344b3f96a62e5f652585e55f1ae7c7883cd45b 2018-06-25 01:03:39 +0200 */
-
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-//////////////////// QCPGraphData
+//////////////////// QCPSimd
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-/*! \class QCPGraphData
-  \brief Holds the data of one single data point for QCPGraph.
-  
-  The stored data is:
-  \li \a key: coordinate on the key axis of this data point (this is the \a mainKey and the \a sortKey)
-  \li \a value: coordinate on the value axis of this data point (this is the \a mainValue)
-  
-  The container for storing multiple data points is \ref QCPGraphDataContainer. It is a typedef for
-  \ref QCPDataContainer with \ref QCPGraphData as the DataType template parameter. See the
-  documentation there for an explanation regarding the data type's generic methods.
-  
+/*! \internal
+
+  Vectorized kernels for the per-point work of drawing dense plottables: transforming coordinates
+  of linear axes to pixels, finding the value span of a run of data points and mapping color map
+  data to gradient colors.
+
+  Each kernel exists as a scalar version and, on x86, as SSE2 and AVX versions. The version is
+  picked once at runtime from the features of the CPU, see \ref level. Setting the environment
+  variable \c QCP_SIMD to \c scalar, \c sse2 or \c avx limits the kernels to that level, which is
+  useful to compare the results and the speed of the different versions.
+
+  All versions perform the same IEEE operations in the same order per data point, so they return
+  identical colors and bit-identical pixel coordinates, also identical to \ref
+  QCPAxis::coordToPixel.
+*/
+namespace QCPSimd {
+
+enum Level { lvScalar, lvSse2, lvAvx };
+
+/*! \internal
+
+  The pixel transform of a linear axis, written such that the same formula covers both
+  orientations and reversed ranges: pixel = ((coord-origin)*sign/size*extent)*outSign+outOffset.
+  Multiplying with a sign of +-1 is exact, so this gives the same result as the branches in \ref
+  QCPAxis::coordToPixel.
+*/
+struct LinearMap
+{
+  double origin, sign, size, extent, outSign, outOffset;
+};
+
+/*! \internal
+
+  Returns the best kernel level supported by the CPU and operating system, possibly limited by the
+  environment variable \c QCP_SIMD. The result is determined on the first call.
+*/
+static Level level()
+{
+  static const Level result = []() -> Level
+  {
+    Level detected = lvScalar;
+#if defined(QCP_SIMD_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    if (info[3] & (1<<26))
+      detected = lvSse2;
+    if ((info[2] & (1<<27)) && (info[2] & (1<<28)) && (_xgetbv(0) & 6) == 6) // OSXSAVE, AVX and OS saves ymm state
+      detected = lvAvx;
+#elif defined(QCP_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+      detected = lvSse2;
+    if (__builtin_cpu_supports("avx"))
+      detected = lvAvx;
+#endif
+    const QByteArray limit = qgetenv("QCP_SIMD").toLower();
+    if (limit == "scalar")
+      detected = lvScalar;
+    else if (limit == "sse2" && detected > lvSse2)
+      detected = lvSse2;
+    return detected;
+  }();
+  return result;
+}
+
+/*! \internal
+
+  Fills \a map with the pixel transform of \a axis. Returns false if the axis isn't linear, in which
+  case \ref QCPAxis::coordToPixel must be used.
+*/
+static bool linearMap(const QCPAxis *axis, LinearMap &map)
+{
+  if (axis->scaleType() != QCPAxis::stLinear)
+    return false;
+  const QCPRange range = axis->range();
+  const QRect rect = axis->axisRect()->rect();
+  map.origin = axis->rangeReversed() ? range.upper : range.lower;
+  map.sign = axis->rangeReversed() ? -1 : 1;
+  map.size = range.size();
+  if (axis->orientation() == Qt::Horizontal)
+  {
+    map.extent = rect.width();
+    map.outSign = 1;
+    map.outOffset = rect.left();
+  } else
+  {
+    map.extent = rect.height();
+    map.outSign = -1;
+    map.outOffset = rect.bottom();
+  }
+  return true;
+}
+
+static inline double mapCoord(double coord, const LinearMap &map)
+{
+  return ((coord-map.origin)*map.sign/map.size*map.extent)*map.outSign+map.outOffset;
+}
+
+static void mapPairsScalar(const double *in0, const double *in1, int inStride, int count, const LinearMap &map0, const LinearMap &map1, double *out)
+{
+  for (int i=0; i<count; ++i)
+  {
+    out[2*i] = mapCoord(in0[i*inStride], map0);
+    out[2*i+1] = mapCoord(in1[i*inStride], map1);
+  }
+}
+
+static void valueSpanScalar(const double *values, int stride, int count, double &minValue, double &maxValue)
+{
+  for (int i=0; i<count; ++i)
+  {
+    const double value = values[i*stride];
+    minValue = value < minValue ? value : minValue;
+    maxValue = value > maxValue ? value : maxValue;
+  }
+}
+
+// the clamping is written like min_pd/max_pd, so NaN values get index 0 in all versions
+static void colorizeLinearScalar(const double *data, int stride, int count, double lower, double posToIndexFactor, const QRgb *colors, int levelCount, QRgb *out)
+{
+  const double maxIndex = levelCount-1;
+  for (int i=0; i<count; ++i)
+  {
+    double index = (data[i*stride]-lower)*posToIndexFactor;
+    index = index > 0 ? index : 0;
+    index = index < maxIndex ? index : maxIndex;
+    out[i] = colors[(int)index];
+  }
+}
+
+#ifdef QCP_SIMD_X86
+QCP_SIMD_TARGET("sse2")
+static void mapPairsSse2(const double *in0, const double *in1, int inStride, int count, const LinearMap &map0, const LinearMap &map1, double *out)
+{
+  const __m128d origin = _mm_setr_pd(map0.origin, map1.origin);
+  const __m128d sign = _mm_setr_pd(map0.sign, map1.sign);
+  const __m128d size = _mm_setr_pd(map0.size, map1.size);
+  const __m128d extent = _mm_setr_pd(map0.extent, map1.extent);
+  const __m128d outSign = _mm_setr_pd(map0.outSign, map1.outSign);
+  const __m128d outOffset = _mm_setr_pd(map0.outOffset, map1.outOffset);
+  int i = 0;
+  if (inStride == 2 && qAbs(in0-in1) == 1) // interleaved pairs, e.g. QCPGraphData
+  {
+    const double *pairs = qMin(in0, in1);
+    const bool swapped = in0 > in1;
+    for (; i<count; ++i)
+    {
+      __m128d p = _mm_loadu_pd(pairs+2*i);
+      if (swapped)
+        p = _mm_shuffle_pd(p, p, 1);
+      p = _mm_add_pd(_mm_mul_pd(_mm_mul_pd(_mm_div_pd(_mm_mul_pd(_mm_sub_pd(p, origin), sign), size), extent), outSign), outOffset);
+      _mm_storeu_pd(out+2*i, p);
+    }
+  }
+  mapPairsScalar(in0+i*inStride, in1+i*inStride, inStride, count-i, map0, map1, out+2*i);
+}
+
+QCP_SIMD_TARGET("avx")
+static void mapPairsAvx(const double *in0, const double *in1, int inStride, int count, const LinearMap &map0, const LinearMap &map1, double *out)
+{
+  const __m256d origin = _mm256_setr_pd(map0.origin, map1.origin, map0.origin, map1.origin);
+  const __m256d sign = _mm256_setr_pd(map0.sign, map1.sign, map0.sign, map1.sign);
+  const __m256d size = _mm256_setr_pd(map0.size, map1.size, map0.size, map1.size);
+  const __m256d extent = _mm256_setr_pd(map0.extent, map1.extent, map0.extent, map1.extent);
+  const __m256d outSign = _mm256_setr_pd(map0.outSign, map1.outSign, map0.outSign, map1.outSign);
+  const __m256d outOffset = _mm256_setr_pd(map0.outOffset, map1.outOffset, map0.outOffset, map1.outOffset);
+  int i = 0;
+  if (inStride == 2 && qAbs(in0-in1) == 1) // interleaved pairs, e.g. QCPGraphData
+  {
+    const double *pairs = qMin(in0, in1);
+    const bool swapped = in0 > in1;
+    for (; i+2<=count; i+=2)
+    {
+      __m256d p = _mm256_loadu_pd(pairs+2*i);
+      if (swapped)
+        p = _mm256_permute_pd(p, 0x5);
+      p = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_div_pd(_mm256_mul_pd(_mm256_sub_pd(p, origin), sign), size), extent), outSign), outOffset);
+      _mm256_storeu_pd(out+2*i, p);
+    }
+  }
+  mapPairsScalar(in0+i*inStride, in1+i*inStride, inStride, count-i, map0, map1, out+2*i);
+}
+
+// min_pd(a, b) and max_pd(a, b) return b unless a compares less/greater, exactly like the scalar version, so NaN values are skipped
+QCP_SIMD_TARGET("sse2")
+static void valueSpanSse2(const double *values, int stride, int count, double &minValue, double &maxValue)
+{
+  __m128d lower = _mm_set1_pd(minValue);
+  __m128d upper = _mm_set1_pd(maxValue);
+  int i = 0;
+  for (; i+2<=count; i+=2)
+  {
+    const __m128d v = stride == 1 ? _mm_loadu_pd(values+i) : _mm_loadh_pd(_mm_load_sd(values+i*stride), values+(i+1)*stride);
+    lower = _mm_min_pd(v, lower);
+    upper = _mm_max_pd(v, upper);
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, lower);
+  minValue = lanes[1] < lanes[0] ? lanes[1] : lanes[0];
+  _mm_storeu_pd(lanes, upper);
+  maxValue = lanes[1] > lanes[0] ? lanes[1] : lanes[0];
+  valueSpanScalar(values+i*stride, stride, count-i, minValue, maxValue);
+}
+
+QCP_SIMD_TARGET("avx")
+static void valueSpanAvx(const double *values, int stride, int count, double &minValue, double &maxValue)
+{
+  if (stride != 1) // interleaved values can't be loaded four at a time, the SSE2 version is as fast
+  {
+    valueSpanSse2(values, stride, count, minValue, maxValue);
+    return;
+  }
+  __m256d lower = _mm256_set1_pd(minValue);
+  __m256d upper = _mm256_set1_pd(maxValue);
+  int i = 0;
+  for (; i+4<=count; i+=4)
+  {
+    const __m256d v = _mm256_loadu_pd(values+i);
+    lower = _mm256_min_pd(v, lower);
+    upper = _mm256_max_pd(v, upper);
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, lower);
+  minValue = lanes[0];
+  for (int k=1; k<4; ++k)
+    minValue = lanes[k] < minValue ? lanes[k] : minValue;
+  _mm256_storeu_pd(lanes, upper);
+  maxValue = lanes[0];
+  for (int k=1; k<4; ++k)
+    maxValue = lanes[k] > maxValue ? lanes[k] : maxValue;
+  valueSpanScalar(values+i, 1, count-i, minValue, maxValue);
+}
+
+// there is no gather below AVX2, so only the index computation is vectorized, the table lookup stays scalar
+QCP_SIMD_TARGET("sse2")
+static void colorizeLinearSse2(const double *data, int stride, int count, double lower, double posToIndexFactor, const QRgb *colors, int levelCount, QRgb *out)
+{
+  const __m128d lowerV = _mm_set1_pd(lower);
+  const __m128d factor = _mm_set1_pd(posToIndexFactor);
+  const __m128d minIndex = _mm_setzero_pd();
+  const __m128d maxIndex = _mm_set1_pd(levelCount-1);
+  int indices[4];
+  int i = 0;
+  for (; i+4<=count; i+=4)
+  {
+    __m128d v0, v1;
+    if (stride == 1)
+    {
+      v0 = _mm_loadu_pd(data+i);
+      v1 = _mm_loadu_pd(data+i+2);
+    } else
+    {
+      v0 = _mm_loadh_pd(_mm_load_sd(data+i*stride), data+(i+1)*stride);
+      v1 = _mm_loadh_pd(_mm_load_sd(data+(i+2)*stride), data+(i+3)*stride);
+    }
+    v0 = _mm_min_pd(_mm_max_pd(_mm_mul_pd(_mm_sub_pd(v0, lowerV), factor), minIndex), maxIndex);
+    v1 = _mm_min_pd(_mm_max_pd(_mm_mul_pd(_mm_sub_pd(v1, lowerV), factor), minIndex), maxIndex);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), _mm_unpacklo_epi64(_mm_cvttpd_epi32(v0), _mm_cvttpd_epi32(v1)));
+    out[i] = colors[indices[0]];
+    out[i+1] = colors[indices[1]];
+    out[i+2] = colors[indices[2]];
+    out[i+3] = colors[indices[3]];
+  }
+  colorizeLinearScalar(data+i*stride, stride, count-i, lower, posToIndexFactor, colors, levelCount, out+i);
+}
+
+QCP_SIMD_TARGET("avx")
+static void colorizeLinearAvx(const double *data, int stride, int count, double lower, double posToIndexFactor, const QRgb *colors, int levelCount, QRgb *out)
+{
+  if (stride != 1) // columns of a color map can't be loaded four at a time, the SSE2 version is as fast
+  {
+    colorizeLinearSse2(data, stride, count, lower, posToIndexFactor, colors, levelCount, out);
+    return;
+  }
+  const __m256d lowerV = _mm256_set1_pd(lower);
+  const __m256d factor = _mm256_set1_pd(posToIndexFactor);
+  const __m256d minIndex = _mm256_setzero_pd();
+  const __m256d maxIndex = _mm256_set1_pd(levelCount-1);
+  int indices[4];
+  int i = 0;
+  for (; i+4<=count; i+=4)
+  {
+    __m256d v = _mm256_loadu_pd(data+i);
+    v = _mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(_mm256_sub_pd(v, lowerV), factor), minIndex), maxIndex);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), _mm256_cvttpd_epi32(v));
+    out[i] = colors[indices[0]];
+    out[i+1] = colors[indices[1]];
+    out[i+2] = colors[indices[2]];
+    out[i+3] = colors[indices[3]];
+  }
+  colorizeLinearScalar(data+i, 1, count-i, lower, posToIndexFactor, colors, levelCount, out+i);
+}
+#endif // QCP_SIMD_X86
+
+/*! \internal
+
+  Transforms \a count coordinate pairs to pixels and writes them as interleaved pairs to \a out,
+  i.e. out[2*i] = map0(in0[i*inStride]) and out[2*i+1] = map1(in1[i*inStride]).
+
+  \a inStride is 2 for interleaved input like QCPGraphData (in0 and in1 then point to the key and
+  value of the first point, in either order). Only that layout is vectorized, other strides use the
+  scalar loop.
+*/
+static void mapPairs(const double *in0, const double *in1, int inStride, int count, const LinearMap &map0, const LinearMap &map1, double *out)
+{
+#ifdef QCP_SIMD_X86
+  switch (level())
+  {
+    case lvAvx: mapPairsAvx(in0, in1, inStride, count, map0, map1, out); return;
+    case lvSse2: mapPairsSse2(in0, in1, inStride, count, map0, map1, out); return;
+    case lvScalar: break;
+  }
+#endif
+  mapPairsScalar(in0, in1, inStride, count, map0, map1, out);
+}
+
+/*! \internal
+
+  Expands \a minValue and \a maxValue by the \a count values at \a values (every \a stride-th
+  double). NaN values are ignored, but if \a minValue or \a maxValue is NaN on entry, it stays NaN.
+  Pass +inf and -inf to get the span of the values alone.
+*/
+static void valueSpan(const double *values, int stride, int count, double &minValue, double &maxValue)
+{
+#ifdef QCP_SIMD_X86
+  switch (level())
+  {
+    case lvAvx: valueSpanAvx(values, stride, count, minValue, maxValue); return;
+    case lvSse2: valueSpanSse2(values, stride, count, minValue, maxValue); return;
+    case lvScalar: break;
+  }
+#endif
+  valueSpanScalar(values, stride, count, minValue, maxValue);
+}
+
+/*! \internal
+
+  Writes the colors of the \a count values at \a data (every \a stride-th double) to \a out, picking
+  entry <tt>(value-lower)*posToIndexFactor</tt> of the color table \a colors, which has \a levelCount
+  entries. Indices beyond the table are clamped to its first or last entry, NaN values get the
+  first entry. This is the linear, non-periodic case of \ref QCPColorGradient::colorize.
+*/
+static void colorizeLinear(const double *data, int stride, int count, double lower, double posToIndexFactor, const QRgb *colors, int levelCount, QRgb *out)
+{
+#ifdef QCP_SIMD_X86
+  switch (level())
+  {
+    case lvAvx: colorizeLinearAvx(data, stride, count, lower, posToIndexFactor, colors, levelCount, out); return;
+    case lvSse2: colorizeLinearSse2(data, stride, count, lower, posToIndexFactor, colors, levelCount, out); return;
+    case lvScalar: break;
+  }
+#endif
+  colorizeLinearScalar(data, stride, count, lower, posToIndexFactor, colors, levelCount, out);
+}
+
+} // namespace QCPSimd
+
+
+/* including file 'src/plottables/plottable-graph.cpp', size 74194           */
+/* commit ce344b3f96a62e5f652585e55f1ae7c7883cd45b 2018-06-25 01:03:39 +0200 */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPGraphData
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPGraphData
+  \brief Holds the data of one single data point for QCPGraph.
+  
+  The stored data is:
+  \li \a key: coordinate on the key axis of this data point (this is the \a mainKey and the \a sortKey)
+  \li \a value: coordinate on the value axis of this data point (this is the \a mainValue)
+  
+  The container for storing multiple data points is \ref QCPGraphDataContainer. It is a typedef for
+  \ref QCPDataContainer with \ref QCPGraphData as the DataType template parameter. See the
+  documentation there for an explanation regarding the data type's generic methods.
+  
   \see QCPGraphDataContainer
 */
 
@@ -20056,6 +21524,10 @@ QCPGraphData::QCPGraphData(double key, double value) :
   also access and modify the data via the \ref data method, which returns a pointer to the internal
   \ref QCPGraphDataContainer.
   
+  For strip charts that only show the most recent data, set a fixed capacity on the data
+  container, e.g. <tt>graph->data()->setCapacity(100000)</tt>. Adding data then drops the oldest
+  points in constant time and memory, see \ref QCPDataContainer::setCapacity.
+  
   Graphs are used to display single-valued data. Single-valued means that there should only be one
   data point per unique key coordinate. In other words, the graph can't have \a loops. If you do
   want to plot non-single-valued curves, rather use the QCPCurve plottable.
@@ -20106,7 +21578,19 @@ QCPGraphData::QCPGraphData(double key, double value) :
   To directly create a graph inside a plot, you can also use the simpler QCustomPlot::addGraph function.
 */
 QCPGraph::QCPGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) :
-  QCPAbstractPlottable1D<QCPGraphData>(keyAxis, valueAxis)
+  QCPAbstractPlottable1D<QCPGraphData>(keyAxis, valueAxis),
+  mSamplingIndexContainer(0),
+  mSamplingIndexRevision(0),
+  mSamplingIndexOffset(0),
+  mSamplingIndexShift(0),
+  mSamplingIndexCount(0),
+  mIncrementalContainer(0),
+  mIncrementalRevision(0),
+  mIncrementalDropOffset(0),
+  mIncrementalRefKey(0),
+  mIncrementalRefPixel(0),
+  mIncrementalLastKey(0),
+  mIncrementalLastValue(0)
 {
   // special handling for QCPGraphs to maintain the simple graph interface:
   mParentPlot->registerGraph(this);
@@ -20118,6 +21602,8 @@ QCPGraph::QCPGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   setScatterSkip(0);
   setChannelFillGraph(0);
   setAdaptiveSampling(true);
+  setAdaptiveSamplingIndex(false);
+  setIncrementalDrawing(false);
 }
 
 QCPGraph::~QCPGraph()
@@ -20142,6 +21628,8 @@ QCPGraph::~QCPGraph()
 void QCPGraph::setData(QSharedPointer<QCPGraphDataContainer> data)
 {
   mDataContainer = data;
+  mSamplingIndexContainer = 0;
+  mIncrementalRaster = QImage();
 }
 
 /*! \overload
@@ -20158,6 +21646,7 @@ void QCPGraph::setData(QSharedPointer<QCPGraphDataContainer> data)
 void QCPGraph::setData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted)
 {
   mDataContainer->clear();
+  mIncrementalRaster = QImage();
   addData(keys, values, alreadySorted);
 }
 
@@ -20264,6 +21753,67 @@ void QCPGraph::setAdaptiveSampling(bool enabled)
   mAdaptiveSampling = enabled;
 }
 
+/*!
+  Sets whether adaptive sampling of graph lines (see \ref setAdaptiveSampling) shall use a
+  precomputed index of the minimum and maximum values of blocks of 8, 16, 32, ... data points.
+
+  Without the index, every replot with adaptive sampling walks all visible data points. With the
+  index, each pixel column of the graph only costs a few lookups, so replotting a zoomed-out graph
+  of millions of points is roughly proportional to its width in pixels. The drawn lines are
+  identical in both cases.
+
+  The index also speeds up \ref selectTest and \ref selectTestRect, which use it to skip blocks of
+  data points that are too far away from the tested position, or outside the tested rect.
+
+  The index takes about a quarter of the memory of the data itself. It is extended incrementally
+  when data is appended (see \ref QCPDataContainer::revision) and rebuilt once after any other
+  modification of the data, e.g. removing old data points. When a data container with a capacity
+  (\ref QCPDataContainer::setCapacity) drops its oldest data points, the index stays valid and is
+  only rebuilt after as many points were dropped as the container holds.
+
+  By default the index is disabled.
+*/
+void QCPGraph::setAdaptiveSamplingIndex(bool enabled)
+{
+  mAdaptiveSamplingIndex = enabled;
+  if (!mAdaptiveSamplingIndex)
+  {
+    mSamplingIndex.clear();
+    mSamplingIndexContainer = 0;
+  }
+}
+
+/*!
+  Sets whether the graph keeps a raster image of its line between replots, so that a replot after
+  appending data points only draws the line segments to the new points on top of the raster.
+
+  This speeds up strip charts, where new data points arrive continuously and each one causes a
+  replot. The raster is kept as long as the axis rect, the pen, the value axis range and the size
+  of the key axis range don't change. If the key axis range is moved towards larger keys by whole
+  pixels (e.g. to follow the newest data), the raster is scrolled accordingly. Any other change
+  causes the graph to be drawn completely again, which also happens if data was modified other
+  than by appending (see \ref QCPDataContainer::revision), or if a data container with a capacity
+  dropped data points that are still inside the key range.
+
+  Appended data points are connected without adaptive sampling (\ref setAdaptiveSampling), which
+  makes a visible difference only if many points per pixel are appended between two replots. In
+  that case the graph is drawn completely again, too.
+
+  Incremental drawing is only used for the line style \ref lsLine without scatters, fill and
+  selection, on linear key axes, and not for exports like \ref QCustomPlot::savePng. In all other
+  cases the graph is drawn as usual. Since the graph itself is cheap to redraw then, this works
+  best if it is on a layer in mode \ref QCPLayer::lmBuffered together with the plotting hint \ref
+  QCP::phIncrementalReplot, so that the axes aren't redrawn either.
+
+  By default incremental drawing is disabled.
+*/
+void QCPGraph::setIncrementalDrawing(bool enabled)
+{
+  mIncrementalDrawing = enabled;
+  if (!mIncrementalDrawing)
+    mIncrementalRaster = QImage();
+}
+
 /*! \overload
   
   Adds the provided points in \a keys and \a values to the current data. The provided vectors
@@ -20336,6 +21886,82 @@ double QCPGraph::selectTest(const QPointF &pos, bool onlySelectable, QVariant *d
     return -1;
 }
 
+/*!
+  Returns the data points of this graph that lie within \a rect, given in pixel coordinates.
+
+  If the sampling index is enabled (\ref setAdaptiveSamplingIndex), blocks of data points whose
+  values are all outside the value range of \a rect are skipped with a single lookup, so selecting
+  a narrow value band of a large graph only walks the selected data points and the boundaries of
+  the unselected ones. The result is the same as without the index.
+
+  \seebaseclassmethod \ref QCPAbstractPlottable1D::selectTestRect
+*/
+QCPDataSelection QCPGraph::selectTestRect(const QRectF &rect, bool onlySelectable) const
+{
+  if (!mAdaptiveSamplingIndex)
+    return QCPAbstractPlottable1D<QCPGraphData>::selectTestRect(rect, onlySelectable);
+  
+  QCPDataSelection result;
+  if ((onlySelectable && mSelectable == QCP::stNone) || mDataContainer->isEmpty())
+    return result;
+  if (!mKeyAxis || !mValueAxis)
+    return result;
+  
+  // convert rect given in pixels to ranges given in plot coordinates:
+  double key1, value1, key2, value2;
+  pixelsToCoords(rect.topLeft(), key1, value1);
+  pixelsToCoords(rect.bottomRight(), key2, value2);
+  QCPRange keyRange(key1, key2);
+  QCPRange valueRange(value1, value2);
+  const QCPGraphDataContainer::const_iterator dataBegin = mDataContainer->constBegin();
+  const int begin = mDataContainer->findBegin(keyRange.lower, false)-dataBegin;
+  const int end = mDataContainer->findEnd(keyRange.upper, false)-dataBegin;
+  updateSamplingIndex();
+  
+  int currentSegmentBegin = -1; // -1 means we're currently not in a segment that's contained in rect
+  int i = begin;
+  while (i < end)
+  {
+    // find the largest block of the index starting at i with all values outside of the value range:
+    const int position = i+mSamplingIndexShift;
+    int level = -1;
+    while (level+1 < mSamplingIndex.size() && (position & ((8<<(level+1))-1)) == 0 && i+(8<<(level+1)) <= end)
+    {
+      const ValueSpan &span = mSamplingIndex.at(level+1).at(position >> (level+4));
+      if (span.max >= valueRange.lower && span.min <= valueRange.upper)
+        break;
+      ++level;
+    }
+    if (level >= 0) // whole block is outside, so it ends the current segment
+    {
+      if (currentSegmentBegin != -1)
+      {
+        result.addDataRange(QCPDataRange(currentSegmentBegin, i), false);
+        currentSegmentBegin = -1;
+      }
+      i += 8<<level;
+    } else
+    {
+      const QCPGraphDataContainer::const_iterator it = dataBegin+i;
+      const bool contained = valueRange.contains(it->value) && keyRange.contains(it->key);
+      if (currentSegmentBegin == -1 && contained) // start segment
+        currentSegmentBegin = i;
+      else if (currentSegmentBegin != -1 && !contained) // segment just ended
+      {
+        result.addDataRange(QCPDataRange(currentSegmentBegin, i), false);
+        currentSegmentBegin = -1;
+      }
+      ++i;
+    }
+  }
+  // process potential last segment:
+  if (currentSegmentBegin != -1)
+    result.addDataRange(QCPDataRange(currentSegmentBegin, end), false);
+  
+  result.simplify();
+  return result;
+}
+
 /* inherits documentation from base class */
 QCPRange QCPGraph::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const
 {
@@ -20355,6 +21981,21 @@ void QCPGraph::draw(QCPPainter *painter)
   if (mKeyAxis.data()->range().size() <= 0 || mDataContainer->isEmpty()) return;
   if (mLineStyle == lsNone && mScatterStyle.isNone()) return;
   
+  if (mIncrementalDrawing && drawIncremental(painter))
+    return;
+  if (!painter->modes().testFlag(QCPPainter::pmNoCaching)) // tiles are drawn concurrently, see QCustomPlot::setReplotTiles
+    mIncrementalRaster = QImage();
+  drawSegments(painter);
+}
+
+/*! \internal
+
+  Draws the unselected and selected segments of the graph with \a painter, including fills,
+  scatters and the selection decoration. This is the regular drawing of the graph, called by \ref
+  draw.
+*/
+void QCPGraph::drawSegments(QCPPainter *painter)
+{
   QVector<QPointF> lines, scatters; // line and (if necessary) scatter pixel coordinates will be stored here while iterating over segments
   
   // loop over and draw segments of unselected/selected data:
@@ -20416,6 +22057,145 @@ void QCPGraph::draw(QCPPainter *painter)
     mSelectionDecorator->drawDecoration(painter, selection());
 }
 
+/*! \internal
+
+  Draws the graph from the raster of the previous replot, if possible (see \ref
+  setIncrementalDrawing). Returns false if incremental drawing isn't possible for the current
+  graph configuration and \a painter, the caller then draws the graph regularly.
+
+  If the raster is outdated, it is recreated by drawing the whole graph into it with \ref
+  drawSegments. This is the case if the data container's revision changed since the raster was
+  drawn, i.e. data was modified other than by appending. Otherwise, only the line segments from the
+  last drawn data point to the data points appended since are drawn into the raster. Finally the raster is drawn with \a painter.
+
+  The raster covers the clip rect of the graph. Its pixels may be offset from the current axis
+  transform by up to half a pixel along the key axis, because it is only ever scrolled by whole
+  device pixels. New line segments are drawn with the same offset, so the line stays continuous.
+*/
+bool QCPGraph::drawIncremental(QCPPainter *painter)
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (mLineStyle != lsLine || !mScatterStyle.isNone() || mBrush.style() != Qt::NoBrush || !mSelection.isEmpty() || keyAxis->scaleType() != QCPAxis::stLinear)
+    return false;
+  if (painter->modes().testFlag(QCPPainter::pmVectorized) || painter->modes().testFlag(QCPPainter::pmNoCaching))
+    return false;
+  
+  const QRect rect = clipRect().translated(0, -1); // same as the clip rect set by QCPLayer::draw
+  const double dpr = mParentPlot->bufferDevicePixelRatio();
+  const bool keyIsHorizontal = keyAxis->orientation() == Qt::Horizontal;
+  const int keyExtent = keyIsHorizontal ? rect.width() : rect.height();
+  applyDefaultAntialiasingHint(painter);
+  QVector<double> state;
+  state << rect.x() << rect.y() << rect.width() << rect.height() << dpr << keyIsHorizontal << keyAxis->range().size() << keyAxis->rangeReversed()
+        << valueAxis->range().lower << valueAxis->range().upper << valueAxis->scaleType() << valueAxis->rangeReversed()
+        << painter->antialiasing() << mParentPlot->plottingHints().testFlag(QCP::phFastPolylines);
+  
+  // check whether the raster is still valid and find the last data point drawn into it:
+  bool valid = !mIncrementalRaster.isNull() && state == mIncrementalState && mPen == mIncrementalPen &&
+      mDataContainer.data() == mIncrementalContainer && mDataContainer->revision() == mIncrementalRevision;
+  if (valid && mDataContainer->dropOffset() != mIncrementalDropOffset) // the lines to dropped data points must be outside the key range
+    valid = mDataContainer->constBegin()->key < keyAxis->range().lower;
+  QCPGraphDataContainer::const_iterator lastDrawn = mDataContainer->constEnd();
+  if (valid)
+  {
+    lastDrawn = mDataContainer->findBegin(mIncrementalLastKey, false);
+    valid = lastDrawn != mDataContainer->constEnd() && lastDrawn->key == mIncrementalLastKey &&
+        (lastDrawn->value == mIncrementalLastValue || (qIsNaN(lastDrawn->value) && qIsNaN(mIncrementalLastValue)));
+  }
+  valid = valid && mDataContainer->constEnd()-lastDrawn <= 2*keyExtent+2; // more new data is drawn with adaptive sampling
+  
+  // scroll the raster if the key range moved by at least half a device pixel:
+  double offset = keyAxis->coordToPixel(mIncrementalRefKey)-mIncrementalRefPixel; // current pixel minus raster pixel of any key
+  const int scroll = valid ? qRound(offset*dpr) : 0;
+  if (scroll != 0)
+  {
+    // only towards smaller keys, and only if everything drawn so far is inside the raster, otherwise the uncovered part would miss data:
+    const double lastPixel = keyAxis->coordToPixel(mIncrementalLastKey)-offset;
+    const bool towardsSmallerKeys = offset*keyAxis->pixelOrientation() < 0;
+    const bool lastInside = keyIsHorizontal ? lastPixel >= rect.left() && lastPixel <= rect.right()+1 : lastPixel >= rect.top() && lastPixel <= rect.bottom()+1;
+    valid = towardsSmallerKeys && lastInside && qAbs(scroll) < keyExtent*dpr;
+    if (valid)
+    {
+      scrollImage(&mIncrementalRaster, keyIsHorizontal ? scroll : 0, keyIsHorizontal ? 0 : scroll);
+      mIncrementalRefPixel += scroll/dpr;
+      offset = keyAxis->coordToPixel(mIncrementalRefKey)-mIncrementalRefPixel;
+    }
+  }
+  
+  if (!valid) // draw the whole graph into a new raster
+  {
+    mIncrementalRaster = QImage(rect.size()*dpr, QImage::Format_ARGB32_Premultiplied);
+#ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
+    mIncrementalRaster.setDevicePixelRatio(dpr);
+#endif
+    mIncrementalRaster.fill(Qt::transparent);
+    QCPPainter rasterPainter(&mIncrementalRaster);
+    rasterPainter.setAntialiasing(painter->antialiasing());
+    rasterPainter.translate(-rect.topLeft());
+    drawSegments(&rasterPainter);
+    mIncrementalState = state;
+    mIncrementalPen = mPen;
+    mIncrementalContainer = mDataContainer.data();
+    mIncrementalRefKey = keyAxis->range().lower;
+    mIncrementalRefPixel = keyAxis->coordToPixel(mIncrementalRefKey);
+  } else if (mDataContainer->constEnd()-lastDrawn > 1) // draw the segments to the appended data points
+  {
+    QVector<QCPGraphData> newData(mDataContainer->constEnd()-lastDrawn);
+    std::copy(lastDrawn, mDataContainer->constEnd(), newData.begin());
+    QCPPainter rasterPainter(&mIncrementalRaster);
+    rasterPainter.setAntialiasing(painter->antialiasing());
+    rasterPainter.translate(-rect.topLeft()-(keyIsHorizontal ? QPointF(offset, 0) : QPointF(0, offset)));
+    rasterPainter.setPen(mPen);
+    rasterPainter.setBrush(Qt::NoBrush);
+    drawLinePlot(&rasterPainter, dataToLines(newData));
+  }
+  mIncrementalRevision = mDataContainer->revision();
+  mIncrementalDropOffset = mDataContainer->dropOffset();
+  mIncrementalLastKey = (mDataContainer->constEnd()-1)->key;
+  mIncrementalLastValue = (mDataContainer->constEnd()-1)->value;
+  
+  painter->drawImage(rect.topLeft(), mIncrementalRaster);
+  return true;
+}
+
+/*! \internal
+
+  Moves the contents of \a image, which must have a 32 bit format, by \a dx and \a dy pixels. The
+  uncovered pixels become transparent.
+*/
+void QCPGraph::scrollImage(QImage *image, int dx, int dy)
+{
+  const int width = image->width();
+  const int height = image->height();
+  const int bytesPerLine = image->bytesPerLine();
+  uchar *bits = image->bits();
+  if (dx > 0)
+  {
+    for (int y=0; y<height; ++y)
+    {
+      memmove(bits+y*bytesPerLine+dx*4, bits+y*bytesPerLine, (width-dx)*4);
+      memset(bits+y*bytesPerLine, 0, dx*4);
+    }
+  } else if (dx < 0)
+  {
+    for (int y=0; y<height; ++y)
+    {
+      memmove(bits+y*bytesPerLine, bits+y*bytesPerLine-dx*4, (width+dx)*4);
+      memset(bits+y*bytesPerLine+(width+dx)*4, 0, -dx*4);
+    }
+  }
+  if (dy > 0)
+  {
+    memmove(bits+dy*bytesPerLine, bits, (height-dy)*bytesPerLine);
+    memset(bits, 0, dy*bytesPerLine);
+  } else if (dy < 0)
+  {
+    memmove(bits, bits-dy*bytesPerLine, (height+dy)*bytesPerLine);
+    memset(bits+(height+dy)*bytesPerLine, 0, -dy*bytesPerLine);
+  }
+}
+
 /* inherits documentation from base class */
 void QCPGraph::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
 {
@@ -20575,9 +22355,22 @@ QVector<QPointF> QCPGraph::dataToLines(const QVector<QCPGraphData> &data) const
   if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return result; }
 
   result.resize(data.size());
+  if (data.isEmpty())
+    return result;
   
-  // transform data points to pixels:
-  if (keyAxis->orientation() == Qt::Vertical)
+  // transform data points to pixels, with vectorized kernels if both axes are linear:
+  QCPSimd::LinearMap keyMap, valueMap;
+  if (sizeof(qreal) == sizeof(double) && QCPSimd::linearMap(keyAxis, keyMap) && QCPSimd::linearMap(valueAxis, valueMap))
+  {
+    const double *keys = &data.first().key;
+    const double *values = &data.first().value;
+    const int stride = int(sizeof(QCPGraphData)/sizeof(double));
+    double *out = reinterpret_cast<double*>(&result.first().rx());
+    if (keyAxis->orientation() == Qt::Vertical)
+      QCPSimd::mapPairs(values, keys, stride, data.size(), valueMap, keyMap, out);
+    else
+      QCPSimd::mapPairs(keys, values, stride, data.size(), keyMap, valueMap, out);
+  } else if (keyAxis->orientation() == Qt::Vertical)
   {
     for (int i=0; i<data.size(); ++i)
     {
@@ -20850,8 +22643,7 @@ void QCPGraph::drawScatterPlot(QCPPainter *painter, const QVector<QPointF> &scat
 {
   applyScattersAntialiasingHint(painter);
   style.applyTo(painter, mPen);
-  for (int i=0; i<scatters.size(); ++i)
-    style.drawShape(painter, scatters.at(i).x(), scatters.at(i).y());
+  style.drawShapes(painter, scatters);
 }
 
 /*!  \internal
@@ -20933,38 +22725,50 @@ void QCPGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGr
     double keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor)); // interval of one pixel on screen when mapped to plot key coordinates
     bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
     int intervalDataCount = 1;
-    ++it; // advance iterator to second data point because adaptive sampling works in 1 point retrospect
-    while (it != end)
-    {
-      if (it->key < currentIntervalStartKey+keyEpsilon) // data point is still within same pixel, so skip it and expand value span of this cluster if necessary
+    // jump from pixel interval to pixel interval, taking the value span of each from the sampling
+    // index if enabled, or else from a vectorized scan of its values:
+    if (mAdaptiveSamplingIndex)
+      updateSamplingIndex();
+    const QCPGraphDataContainer::const_iterator dataBegin = mDataContainer->constBegin();
+    while (true)
+    {
+      // find first data point of next pixel interval, searching exponentially since intervals are usually short:
+      const QCPGraphData intervalEnd = QCPGraphData::fromSortKey(currentIntervalStartKey+keyEpsilon);
+      qint64 step = 1;
+      while (step < end-currentIntervalFirstPoint && qcpLessThanSortKey<QCPGraphData>(*(currentIntervalFirstPoint+step), intervalEnd))
+        step *= 2;
+      it = std::lower_bound(currentIntervalFirstPoint+step/2+1, currentIntervalFirstPoint+qMin<qint64>(step, end-currentIntervalFirstPoint), intervalEnd, qcpLessThanSortKey<QCPGraphData>);
+      intervalDataCount = int(it-currentIntervalFirstPoint);
+      minValue = currentIntervalFirstPoint->value;
+      maxValue = currentIntervalFirstPoint->value;
+      if (intervalDataCount >= 2 && mAdaptiveSamplingIndex)
       {
-        if (it->value < minValue)
-          minValue = it->value;
-        else if (it->value > maxValue)
-          maxValue = it->value;
-        ++intervalDataCount;
-      } else // new pixel interval started
+        double spanMin, spanMax;
+        getSamplingIndexSpan(int(currentIntervalFirstPoint-dataBegin)+1, int(it-dataBegin), spanMin, spanMax);
+        if (spanMin < minValue)
+          minValue = spanMin;
+        if (spanMax > maxValue)
+          maxValue = spanMax;
+      } else if (intervalDataCount >= 2)
+        QCPSimd::valueSpan(&(currentIntervalFirstPoint+1)->value, int(sizeof(QCPGraphData)/sizeof(double)), intervalDataCount-1, minValue, maxValue);
+      if (it == end) // last interval is handled below
+        break;
+      
+      if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
       {
-        if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
-        {
-          if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point is further away, so first point of this cluster must be at a real data point
-            lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.2, currentIntervalFirstPoint->value));
-          lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.25, minValue));
-          lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
-          if (it->key > currentIntervalStartKey+keyEpsilon*2) // new pixel started further away from previous cluster, so make sure the last point of the cluster is at a real data point
-            lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.8, (it-1)->value));
-        } else
-          lineData->append(QCPGraphData(currentIntervalFirstPoint->key, currentIntervalFirstPoint->value));
-        lastIntervalEndKey = (it-1)->key;
-        minValue = it->value;
-        maxValue = it->value;
-        currentIntervalFirstPoint = it;
-        currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(it->key)+reversedRound));
-        if (keyEpsilonVariable)
-          keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor));
-        intervalDataCount = 1;
-      }
-      ++it;
+        if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point is further away, so first point of this cluster must be at a real data point
+          lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.2, currentIntervalFirstPoint->value));
+        lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.25, minValue));
+        lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
+        if (it->key > currentIntervalStartKey+keyEpsilon*2) // new pixel started further away from previous cluster, so make sure the last point of the cluster is at a real data point
+          lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.8, (it-1)->value));
+      } else
+        lineData->append(QCPGraphData(currentIntervalFirstPoint->key, currentIntervalFirstPoint->value));
+      lastIntervalEndKey = (it-1)->key;
+      currentIntervalFirstPoint = it;
+      currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(it->key)+reversedRound));
+      if (keyEpsilonVariable)
+        keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor));
     }
     // handle last interval:
     if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
@@ -21661,22 +23465,127 @@ double QCPGraph::pointDistance(const QPointF &pixelPoint, QCPGraphDataContainer:
   // calculate distance to graph line if there is one (if so, will probably be smaller than distance to closest data point):
   if (mLineStyle != lsNone)
   {
-    // line displayed, calculate distance to line segments:
-    QVector<QPointF> lineData;
-    getLines(&lineData, QCPDataRange(0, dataCount()));
-    QCPVector2D p(pixelPoint);
-    const int step = mLineStyle==lsImpulse ? 2 : 1; // impulse plot differs from other line styles in that the lineData points are only pairwise connected
-    for (int i=0; i<lineData.size()-1; i+=step)
+    if (mAdaptiveSamplingIndex && mKeyAxis.data()->scaleType() == QCPAxis::stLinear && mValueAxis.data()->scaleType() == QCPAxis::stLinear)
+    {
+      // line segments around pos come first, they usually contain the closest one. The segments
+      // of the other visible data points are checked with the sampling index, which skips all
+      // blocks of data points that can't come closer than that:
+      QCPGraphDataContainer::const_iterator visibleBegin, visibleEnd;
+      getVisibleDataBounds(visibleBegin, visibleEnd, QCPDataRange(0, dataCount()));
+      const int visibleBeginIndex = visibleBegin-mDataContainer->constBegin();
+      const int visibleEndIndex = visibleEnd-mDataContainer->constBegin();
+      const int nearBegin = qBound(visibleBeginIndex, int(begin-mDataContainer->constBegin()), visibleEndIndex);
+      const int nearEnd = qBound(visibleBeginIndex, int(end-mDataContainer->constBegin()), visibleEndIndex);
+      minDistSqr = qMin(minDistSqr, lineDistanceSqr(pixelPoint, QCPDataRange(nearBegin, nearEnd)));
+      if (visibleEndIndex-visibleBeginIndex > 1)
+      {
+        updateSamplingIndex();
+        minDistSqr = indexedLineDistanceSqr(pixelPoint, visibleBeginIndex, nearBegin, visibleEndIndex-1, minDistSqr);
+        minDistSqr = indexedLineDistanceSqr(pixelPoint, qMax(visibleBeginIndex, nearEnd-1), visibleEndIndex-1, visibleEndIndex-1, minDistSqr);
+      }
+    } else
     {
-      const double currentDistSqr = p.distanceSquaredToLine(lineData.at(i), lineData.at(i+1));
-      if (currentDistSqr < minDistSqr)
-        minDistSqr = currentDistSqr;
+      // line displayed, calculate distance to line segments:
+      minDistSqr = qMin(minDistSqr, lineDistanceSqr(pixelPoint, QCPDataRange(0, dataCount())));
     }
   }
   
   return qSqrt(minDistSqr);
 }
 
+/*! \internal
+  
+  Returns the squared distance of \a pixelPoint to the closest line segment of the graph lines (see
+  \ref getLines) of the data points in \a dataRange. If there is no line segment, returns the
+  largest double value.
+  
+  \see pointDistance
+*/
+double QCPGraph::lineDistanceSqr(const QPointF &pixelPoint, const QCPDataRange &dataRange) const
+{
+  double minDistSqr = (std::numeric_limits<double>::max)();
+  QVector<QPointF> lineData;
+  getLines(&lineData, dataRange);
+  QCPVector2D p(pixelPoint);
+  const int step = mLineStyle==lsImpulse ? 2 : 1; // impulse plot differs from other line styles in that the lineData points are only pairwise connected
+  for (int i=0; i<lineData.size()-1; i+=step)
+  {
+    const double currentDistSqr = p.distanceSquaredToLine(lineData.at(i), lineData.at(i+1));
+    if (currentDistSqr < minDistSqr)
+      minDistSqr = currentDistSqr;
+  }
+  return minDistSqr;
+}
+
+/*! \internal
+  
+  Returns the smaller of \a minDistSqr and the squared distance of \a pixelPoint to the closest line
+  segment that starts at a data point with index \a begin (inclusive) to \a end (exclusive). \a
+  lastIndex is the index of the last data point a segment may lead to.
+  
+  The range is divided into the blocks of the sampling index (see \ref updateSamplingIndex). The
+  key and value span of a block and the data point following it bound all its line segments, so
+  blocks whose bounding rect in pixels is farther away than the closest segment found so far are
+  skipped as a whole, and the others are subdivided. Only the lines of remaining blocks of 8 data
+  points are actually generated. Both axes must have a linear scale.
+  
+  \see pointDistance
+*/
+double QCPGraph::indexedLineDistanceSqr(const QPointF &pixelPoint, int begin, int end, int lastIndex, double minDistSqr) const
+{
+  const QCPGraphDataContainer::const_iterator dataBegin = mDataContainer->constBegin();
+  QVector<QPair<int, int> > blocks; // index of first data point and level of the blocks that still need checking, level -1 is a single data point
+  int i = begin;
+  while (i < end)
+  {
+    int level = -1;
+    while (level+1 < mSamplingIndex.size() && ((i+mSamplingIndexShift) & ((8<<(level+1))-1)) == 0 && i+(8<<(level+1)) <= end)
+      ++level;
+    blocks.append(qMakePair(i, level));
+    i += level >= 0 ? 8<<level : 1;
+  }
+  
+  while (!blocks.isEmpty())
+  {
+    const int first = blocks.last().first;
+    const int level = blocks.last().second;
+    blocks.removeLast();
+    const int last = qMin(first+(level >= 0 ? 8<<level : 1), lastIndex);
+    if (level >= 0)
+    {
+      const ValueSpan &span = mSamplingIndex.at(level).at((first+mSamplingIndexShift) >> (level+3));
+      double minValue = span.min;
+      double maxValue = span.max;
+      const double lastValue = (dataBegin+last)->value;
+      if (lastValue < minValue) // NaN values fail both comparisons and are ignored
+        minValue = lastValue;
+      if (lastValue > maxValue)
+        maxValue = lastValue;
+      if (mLineStyle == lsImpulse) // impulses reach down to zero
+      {
+        minValue = qMin(minValue, 0.0);
+        maxValue = qMax(maxValue, 0.0);
+      }
+      if (minValue > maxValue) // only NaN values, so no line segments
+        continue;
+      const QPointF corner1 = coordsToPixels((dataBegin+first)->key, minValue);
+      const QPointF corner2 = coordsToPixels((dataBegin+last)->key, maxValue);
+      const double dx = qMax(0.0, qMax(qMin(corner1.x(), corner2.x())-pixelPoint.x(), pixelPoint.x()-qMax(corner1.x(), corner2.x())));
+      const double dy = qMax(0.0, qMax(qMin(corner1.y(), corner2.y())-pixelPoint.y(), pixelPoint.y()-qMax(corner1.y(), corner2.y())));
+      if (dx*dx+dy*dy >= minDistSqr)
+        continue;
+    }
+    if (level > 0)
+    {
+      // the first half is appended last, so it's checked first:
+      blocks.append(qMakePair(first+(4<<level), level-1));
+      blocks.append(qMakePair(first, level-1));
+    } else
+      minDistSqr = qMin(minDistSqr, lineDistanceSqr(pixelPoint, QCPDataRange(first, last+1)));
+  }
+  return minDistSqr;
+}
+
 /*! \internal
   
   Finds the highest index of \a data, whose points y value is just below \a y. Assumes y values in
@@ -21699,6 +23608,114 @@ int QCPGraph::findIndexBelowY(const QVector<QPointF> *data, double y) const
   }
   return -1;
 }
+
+/*! \internal
+  
+  Brings the sampling index (see \ref setAdaptiveSamplingIndex) up to date with the current data
+  container. If data was only appended since the last call, only the blocks of the appended data
+  points are added. Otherwise the index is rebuilt from scratch.
+  
+  Level \a i of the index holds the minimum and maximum value of each complete block of 8<<i data
+  points, NaN values are ignored. Blocks that have only NaN values hold an empty span (+inf, -inf).
+  
+  The blocks are aligned to positions that don't change when the container drops its oldest data
+  points (\ref QCPDataContainer::dropOffset): the data point with index i is at position
+  i+mSamplingIndexShift. Blocks that reach below mSamplingIndexShift hold dropped data points and
+  are never looked up. Once the shift exceeds the number of data points, the index is rebuilt,
+  so it doesn't grow beyond twice the size of the data.
+*/
+void QCPGraph::updateSamplingIndex() const
+{
+  const QCPGraphDataContainer *data = mDataContainer.data();
+  qint64 shift = data->dropOffset()-mSamplingIndexOffset;
+  if (data != mSamplingIndexContainer || data->revision() != mSamplingIndexRevision || shift < 0 || shift > data->size() || shift+data->size() < mSamplingIndexCount)
+  {
+    mSamplingIndex.clear();
+    mSamplingIndexContainer = data;
+    mSamplingIndexRevision = data->revision();
+    mSamplingIndexOffset = data->dropOffset();
+    mSamplingIndexCount = 0;
+    shift = 0;
+  }
+  
+  const int count = int(shift)+data->size();
+  if (count == mSamplingIndexCount) // nothing is written if the index is up to date, so tiles may call this concurrently
+    return;
+  mSamplingIndexShift = int(shift);
+  const QCPGraphDataContainer::const_iterator dataBegin = data->constBegin();
+  for (int level=0; (count >> (level+3)) > 0; ++level)
+  {
+    if (level == mSamplingIndex.size())
+      mSamplingIndex.append(QVector<ValueSpan>());
+    const int blockCount = count >> (level+3);
+    int block = mSamplingIndex.at(level).size();
+    mSamplingIndex[level].resize(blockCount);
+    for (; block<blockCount; ++block)
+    {
+      ValueSpan span = {std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+      if (level == 0 && block*8 >= mSamplingIndexShift)
+      {
+        const QCPGraphDataContainer::const_iterator blockBegin = dataBegin+(block*8-mSamplingIndexShift);
+        for (QCPGraphDataContainer::const_iterator it = blockBegin; it != blockBegin+8; ++it)
+        {
+          if (it->value < span.min)
+            span.min = it->value;
+          if (it->value > span.max)
+            span.max = it->value;
+        }
+      } else if (level > 0)
+      {
+        const ValueSpan &left = mSamplingIndex.at(level-1).at(2*block);
+        const ValueSpan &right = mSamplingIndex.at(level-1).at(2*block+1);
+        span.min = right.min < left.min ? right.min : left.min;
+        span.max = right.max > left.max ? right.max : left.max;
+      }
+      mSamplingIndex[level][block] = span;
+    }
+  }
+  mSamplingIndexCount = count;
+}
+
+/*! \internal
+  
+  Returns via \a minValue and \a maxValue the smallest and largest value of the data points with
+  indices \a begin (inclusive) to \a end (exclusive), ignoring NaN values. If there are only NaN
+  values in the range, \a minValue is +inf and \a maxValue is -inf.
+  
+  The range is covered with the largest blocks of the sampling index that fit, so this takes
+  O(log n) steps. \ref updateSamplingIndex must have been called before.
+*/
+void QCPGraph::getSamplingIndexSpan(int begin, int end, double &minValue, double &maxValue) const
+{
+  minValue = std::numeric_limits<double>::infinity();
+  maxValue = -std::numeric_limits<double>::infinity();
+  const QCPGraphDataContainer::const_iterator dataBegin = mDataContainer->constBegin();
+  int i = begin;
+  while (i < end)
+  {
+    const int position = i+mSamplingIndexShift;
+    int level = -1;
+    while (level+1 < mSamplingIndex.size() && (position & ((8<<(level+1))-1)) == 0 && i+(8<<(level+1)) <= end)
+      ++level;
+    if (level >= 0)
+    {
+      const ValueSpan &span = mSamplingIndex.at(level).at(position >> (level+3));
+      if (span.min < minValue)
+        minValue = span.min;
+      if (span.max > maxValue)
+        maxValue = span.max;
+      i += 8<<level;
+    } else
+    {
+      const double value = (dataBegin+i)->value;
+      if (value < minValue)
+        minValue = value;
+      if (value > maxValue)
+        maxValue = value;
+      ++i;
+    }
+  }
+}
 /* end of 'src/plottables/plottable-graph.cpp' */
 
 
@@ -22240,9 +24257,7 @@ void QCPCurve::drawScatterPlot(QCPPainter *painter, const QVector<QPointF> &poin
   // draw scatter point symbols:
   applyScattersAntialiasingHint(painter);
   style.applyTo(painter, mPen);
-  for (int i=0; i<points.size(); ++i)
-    if (!qIsNaN(points.at(i).x()) && !qIsNaN(points.at(i).y()))
-      style.drawShape(painter,  points.at(i));
+  style.drawShapes(painter, points);
 }
 
 /*! \internal
@@ -24915,8 +26930,10 @@ void QCPStatisticalBox::drawStatisticalBox(QCPPainter *painter, QCPStatisticalBo
   // draw outliers:
   applyScattersAntialiasingHint(painter);
   outlierStyle.applyTo(painter, mPen);
+  QVector<QPointF> outliers(it->outliers.size());
   for (int i=0; i<it->outliers.size(); ++i)
-    outlierStyle.drawShape(painter, coordsToPixels(it->key, it->outliers.at(i)));
+    outliers[i] = coordsToPixels(it->key, it->outliers.at(i));
+  outlierStyle.drawShapes(painter, outliers);
 }
 
 /*!  \internal
@@ -25017,6 +27034,10 @@ QVector<QLineF> QCPStatisticalBox::getWhiskerBarLines(QCPStatisticalBoxDataConta
   coordinate with \ref setData. plot coordinate to cell index transformations and vice versa are
   provided by the functions \ref coordToCell and \ref cellToCoord.
   
+  The rectangle of cells changed by \ref setCell, \ref setData and \ref setAlpha since the last
+  replot is tracked, so the \ref QCPColorMap only recolors that part of its image. Updating a few
+  cells of a large map is therefore much cheaper than refilling it.
+  
   A \ref QCPColorMapData also holds an on-demand two-dimensional array of alpha values which (if
   allocated) has the same size as the data map. It can be accessed via \ref setAlpha, \ref
   fillAlpha and \ref clearAlpha. The memory for the alpha map is only allocated if needed, i.e. on
@@ -25111,6 +27132,7 @@ QCPColorMapData &QCPColorMapData::operator=(const QCPColorMapData &other)
     }
     mDataBounds = other.mDataBounds;
     mDataModified = true;
+    mModifiedCells = QRect(0, 0, mKeySize, mValueSize);
   }
   return *this;
 }
@@ -25192,6 +27214,7 @@ void QCPColorMapData::setSize(int keySize, int valueSize)
       createAlpha();
     
     mDataModified = true;
+    mModifiedCells = QRect(0, 0, mKeySize, mValueSize);
   }
 }
 
@@ -25295,6 +27318,7 @@ void QCPColorMapData::setData(double key, double value, double z)
     if (z > mDataBounds.upper)
       mDataBounds.upper = z;
      mDataModified = true;
+     mModifiedCells |= QRect(keyCell, valueCell, 1, 1);
   }
 }
 
@@ -25319,6 +27343,7 @@ void QCPColorMapData::setCell(int keyIndex, int valueIndex, double z)
     if (z > mDataBounds.upper)
       mDataBounds.upper = z;
      mDataModified = true;
+     mModifiedCells |= QRect(keyIndex, valueIndex, 1, 1);
   } else
     qDebug() << Q_FUNC_INFO << "index out of bounds:" << keyIndex << valueIndex;
 }
@@ -25346,6 +27371,7 @@ void QCPColorMapData::setAlpha(int keyIndex, int valueIndex, unsigned char alpha
     {
       mAlpha[valueIndex*mKeySize + keyIndex] = alpha;
       mDataModified = true;
+      mModifiedCells |= QRect(keyIndex, valueIndex, 1, 1);
     }
   } else
     qDebug() << Q_FUNC_INFO << "index out of bounds:" << keyIndex << valueIndex;
@@ -25403,6 +27429,7 @@ void QCPColorMapData::clearAlpha()
     delete[] mAlpha;
     mAlpha = 0;
     mDataModified = true;
+    mModifiedCells = QRect(0, 0, mKeySize, mValueSize);
   }
 }
 
@@ -25416,6 +27443,7 @@ void QCPColorMapData::fill(double z)
     mData[i] = z;
   mDataBounds = QCPRange(z, z);
   mDataModified = true;
+  mModifiedCells = QRect(0, 0, mKeySize, mValueSize);
 }
 
 /*!
@@ -25435,6 +27463,7 @@ void QCPColorMapData::fillAlpha(unsigned char alpha)
     for (int i=0; i<dataCount; ++i)
       mAlpha[i] = alpha;
     mDataModified = true;
+    mModifiedCells = QRect(0, 0, mKeySize, mValueSize);
   }
 }
 
@@ -25655,7 +27684,8 @@ QCPColorMap::QCPColorMap(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   mGradient(QCPColorGradient::gpCold),
   mInterpolate(true),
   mTightBoundary(false),
-  mMapImageInvalidated(true)
+  mMapImageInvalidated(true),
+  mMapImageOrientation(Qt::Horizontal)
 {
 }
 
@@ -25956,6 +27986,9 @@ QCPRange QCPColorMap::getValueRange(bool &foundRange, QCP::SignDomain inSignDoma
   has been invalidated for a different reason (e.g. a change of the data range with \ref
   setDataRange).
   
+  If only the data has been modified and the image still has the right size, only the rectangle of
+  cells that was modified since the last update (see \ref QCPColorMapData::setCell) is recolored.
+  
   If the map cell count is low, the image created will be oversampled in order to avoid a
   QPainter::drawImage bug which makes inner pixel boundaries jitter when stretch-drawing images
   without smooth transform enabled. Accordingly, oversampling isn't performed if \ref
@@ -25973,11 +28006,20 @@ void QCPColorMap::updateMapImage()
   int keyOversamplingFactor = mInterpolate ? 1 : (int)(1.0+100.0/(double)keySize); // make mMapImage have at least size 100, factor becomes 1 if size > 200 or interpolation is on
   int valueOversamplingFactor = mInterpolate ? 1 : (int)(1.0+100.0/(double)valueSize); // make mMapImage have at least size 100, factor becomes 1 if size > 200 or interpolation is on
   
+  bool fullUpdate = mMapImageInvalidated; // whether all cells must be recolored, or only the ones modified since the last update
+  if (keyAxis->orientation() != mMapImageOrientation) // a square map keeps its image size when transposed, so the size checks below wouldn't catch this
+    fullUpdate = true;
+  
   // resize mMapImage to correct dimensions including possible oversampling factors, according to key/value axes orientation:
   if (keyAxis->orientation() == Qt::Horizontal && (mMapImage.width() != keySize*keyOversamplingFactor || mMapImage.height() != valueSize*valueOversamplingFactor))
+  {
     mMapImage = QImage(QSize(keySize*keyOversamplingFactor, valueSize*valueOversamplingFactor), format);
-  else if (keyAxis->orientation() == Qt::Vertical && (mMapImage.width() != valueSize*valueOversamplingFactor || mMapImage.height() != keySize*keyOversamplingFactor))
+    fullUpdate = true;
+  } else if (keyAxis->orientation() == Qt::Vertical && (mMapImage.width() != valueSize*valueOversamplingFactor || mMapImage.height() != keySize*keyOversamplingFactor))
+  {
     mMapImage = QImage(QSize(valueSize*valueOversamplingFactor, keySize*keyOversamplingFactor), format);
+    fullUpdate = true;
+  }
   
   if (mMapImage.isNull())
   {
@@ -25991,38 +28033,46 @@ void QCPColorMap::updateMapImage()
     {
       // resize undersampled map image to actual key/value cell sizes:
       if (keyAxis->orientation() == Qt::Horizontal && (mUndersampledMapImage.width() != keySize || mUndersampledMapImage.height() != valueSize))
+      {
         mUndersampledMapImage = QImage(QSize(keySize, valueSize), format);
-      else if (keyAxis->orientation() == Qt::Vertical && (mUndersampledMapImage.width() != valueSize || mUndersampledMapImage.height() != keySize))
+        fullUpdate = true;
+      } else if (keyAxis->orientation() == Qt::Vertical && (mUndersampledMapImage.width() != valueSize || mUndersampledMapImage.height() != keySize))
+      {
         mUndersampledMapImage = QImage(QSize(valueSize, keySize), format);
+        fullUpdate = true;
+      }
       localMapImage = &mUndersampledMapImage; // make the colorization run on the undersampled image
     } else if (!mUndersampledMapImage.isNull())
       mUndersampledMapImage = QImage(); // don't need oversampling mechanism anymore (map size has changed) but mUndersampledMapImage still has nonzero size, free it
     
+    const QRect allCells(0, 0, keySize, valueSize);
+    const QRect cells = fullUpdate ? allCells : mMapData->mModifiedCells & allCells; // x is the key index, y the value index
     const double *rawData = mMapData->mData;
     const unsigned char *rawAlpha = mMapData->mAlpha;
     if (keyAxis->orientation() == Qt::Horizontal)
     {
       const int lineCount = valueSize;
       const int rowCount = keySize;
-      for (int line=0; line<lineCount; ++line)
+      for (int line=cells.top(); line<=cells.bottom(); ++line)
       {
-        QRgb* pixels = reinterpret_cast<QRgb*>(localMapImage->scanLine(lineCount-1-line)); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
+        QRgb* pixels = reinterpret_cast<QRgb*>(localMapImage->scanLine(lineCount-1-line))+cells.left(); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
+        const int offset = line*rowCount+cells.left();
         if (rawAlpha)
-          mGradient.colorize(rawData+line*rowCount, rawAlpha+line*rowCount, mDataRange, pixels, rowCount, 1, mDataScaleType==QCPAxis::stLogarithmic);
+          mGradient.colorize(rawData+offset, rawAlpha+offset, mDataRange, pixels, cells.width(), 1, mDataScaleType==QCPAxis::stLogarithmic);
         else
-          mGradient.colorize(rawData+line*rowCount, mDataRange, pixels, rowCount, 1, mDataScaleType==QCPAxis::stLogarithmic);
+          mGradient.colorize(rawData+offset, mDataRange, pixels, cells.width(), 1, mDataScaleType==QCPAxis::stLogarithmic);
       }
     } else // keyAxis->orientation() == Qt::Vertical
     {
       const int lineCount = keySize;
-      const int rowCount = valueSize;
-      for (int line=0; line<lineCount; ++line)
+      for (int line=cells.left(); line<=cells.right(); ++line)
       {
-        QRgb* pixels = reinterpret_cast<QRgb*>(localMapImage->scanLine(lineCount-1-line)); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
+        QRgb* pixels = reinterpret_cast<QRgb*>(localMapImage->scanLine(lineCount-1-line))+cells.top(); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
+        const int offset = cells.top()*lineCount+line;
         if (rawAlpha)
-          mGradient.colorize(rawData+line, rawAlpha+line, mDataRange, pixels, rowCount, lineCount, mDataScaleType==QCPAxis::stLogarithmic);
+          mGradient.colorize(rawData+offset, rawAlpha+offset, mDataRange, pixels, cells.height(), lineCount, mDataScaleType==QCPAxis::stLogarithmic);
         else
-          mGradient.colorize(rawData+line, mDataRange, pixels, rowCount, lineCount, mDataScaleType==QCPAxis::stLogarithmic);
+          mGradient.colorize(rawData+offset, mDataRange, pixels, cells.height(), lineCount, mDataScaleType==QCPAxis::stLogarithmic);
       }
     }
     
@@ -26035,7 +28085,9 @@ void QCPColorMap::updateMapImage()
     }
   }
   mMapData->mDataModified = false;
+  mMapData->mModifiedCells = QRect();
   mMapImageInvalidated = false;
+  mMapImageOrientation = keyAxis->orientation();
 }
 
 /* inherits documentation from base class */
@@ -26045,7 +28097,7 @@ void QCPColorMap::draw(QCPPainter *painter)
   if (!mKeyAxis || !mValueAxis) return;
   applyDefaultAntialiasingHint(painter);
   
-  if (mMapData->mDataModified || mMapImageInvalidated)
+  if (mMapData->mDataModified || mMapImageInvalidated || mKeyAxis.data()->orientation() != mMapImageOrientation)
     updateMapImage();
   
   // use buffer if painting vectorized (PDF):
@@ -51,6 +51,7 @@
 #include <QtCore/QPointer>
 #include <QtCore/QSharedPointer>
 #include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
 #include <QtGui/QPainter>
 #include <QtGui/QPaintEvent>
 #include <QtGui/QMouseEvent>
@@ -65,6 +66,12 @@
 #include <QtCore/QStack>
 #include <QtCore/QCache>
 #include <QtCore/QMargins>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QMutex>
+#include <QtGui/QImage>
 #include <qmath.h>
 #include <limits>
 #include <algorithm>
@@ -243,6 +250,8 @@ enum PlottingHint { phNone              = 0x000 ///< <tt>0x000</tt> No hints are
                     ,phImmediateRefresh = 0x002 ///< <tt>0x002</tt> causes an immediate repaint() instead of a soft update() when QCustomPlot::replot() is called with parameter \ref QCustomPlot::rpRefreshHint.
                                                 ///<                This is set by default to prevent the plot from freezing on fast consecutive replots (e.g. user drags ranges with mouse).
                     ,phCacheLabels      = 0x004 ///< <tt>0x004</tt> axis (tick) labels will be cached as pixmaps, increasing replot performance.
+                    ,phIncrementalReplot = 0x008 ///< <tt>0x008</tt> QCustomPlot::replot() only redraws the layers in mode \ref QCPLayer::lmBuffered, if the viewport and all axis ranges are unchanged
+                                                 ///<                since the last full replot. See \ref QCustomPlot::replot for details.
                   };
 Q_DECLARE_FLAGS(PlottingHints, PlottingHint)
 
@@ -538,6 +547,8 @@ public:
   virtual void donePainting() {}
   virtual void draw(QCPPainter *painter) const = 0;
   virtual void clear(const QColor &color) = 0;
+  virtual int tileCount() const { return 1; }
+  virtual QCPPainter *startPaintingTile(int index) { return index == 0 ? startPainting() : 0; }
   
 protected:
   // property members:
@@ -572,6 +583,50 @@ protected:
 };
 
 
+class QCP_LIB_DECL QCPPaintBufferImage : public QCPAbstractPaintBuffer
+{
+public:
+  explicit QCPPaintBufferImage(const QSize &size, double devicePixelRatio);
+  virtual ~QCPPaintBufferImage();
+  
+  // reimplemented virtual methods:
+  virtual QCPPainter *startPainting() Q_DECL_OVERRIDE;
+  virtual void draw(QCPPainter *painter) const Q_DECL_OVERRIDE;
+  void clear(const QColor &color) Q_DECL_OVERRIDE;
+  
+protected:
+  // non-property members:
+  QImage mBuffer;
+  
+  // reimplemented virtual methods:
+  virtual void reallocateBuffer() Q_DECL_OVERRIDE;
+};
+
+
+class QCP_LIB_DECL QCPPaintBufferTiledImage : public QCPPaintBufferImage
+{
+public:
+  explicit QCPPaintBufferTiledImage(const QSize &size, double devicePixelRatio, int tiles);
+  virtual ~QCPPaintBufferTiledImage();
+  
+  // reimplemented virtual methods:
+  virtual int tileCount() const Q_DECL_OVERRIDE { return mTiles.size(); }
+  virtual QCPPainter *startPaintingTile(int index) Q_DECL_OVERRIDE;
+  
+protected:
+  // non-property members:
+  int mTileLimit;
+  QVector<QImage> mTiles;
+  QVector<int> mTileOffsets;
+  
+  // reimplemented virtual methods:
+  virtual void reallocateBuffer() Q_DECL_OVERRIDE;
+  
+  // non-virtual methods:
+  void updateTiles();
+};
+
+
 #ifdef QCP_OPENGL_PBUFFER
 class QCP_LIB_DECL QCPPaintBufferGlPbuffer : public QCPAbstractPaintBuffer
 {
@@ -635,6 +690,7 @@ class QCP_LIB_DECL QCPLayer : public QObject
   Q_PROPERTY(QList<QCPLayerable*> children READ children)
   Q_PROPERTY(bool visible READ visible WRITE setVisible)
   Q_PROPERTY(LayerMode mode READ mode WRITE setMode)
+  Q_PROPERTY(bool tiled READ tiled WRITE setTiled)
   /// \endcond
 public:
   
@@ -660,15 +716,19 @@ public:
   QList<QCPLayerable*> children() const { return mChildren; }
   bool visible() const { return mVisible; }
   LayerMode mode() const { return mMode; }
+  bool tiled() const { return mTiled; }
   
   // setters:
   void setVisible(bool visible);
   void setMode(LayerMode mode);
+  void setTiled(bool enabled);
   
   // non-virtual methods:
   void replot();
   
 protected:
+  class TileTask;
+  
   // property members:
   QCustomPlot *mParentPlot;
   QString mName;
@@ -676,6 +736,7 @@ protected:
   QList<QCPLayerable*> mChildren;
   bool mVisible;
   LayerMode mMode;
+  bool mTiled;
   
   // non-property members:
   QWeakPointer<QCPAbstractPaintBuffer> mPaintBuffer;
@@ -683,6 +744,7 @@ protected:
   // non-virtual methods:
   void draw(QCPPainter *painter);
   void drawToPaintBuffer();
+  void drawTile(QCPAbstractPaintBuffer *buffer, int index);
   void addChild(QCPLayerable *layerable, bool prepend);
   void removeChild(QCPLayerable *layerable);
   
@@ -1558,6 +1620,7 @@ public:
   TickStepStrategy tickStepStrategy() const { return mTickStepStrategy; }
   int tickCount() const { return mTickCount; }
   double tickOrigin() const { return mTickOrigin; }
+  int revision() const { return mRevision; }
   
   // setters:
   void setTickStepStrategy(TickStepStrategy strategy);
@@ -1573,6 +1636,9 @@ protected:
   int mTickCount;
   double mTickOrigin;
   
+  // non-property members:
+  int mRevision;
+  
   // introduced virtual methods:
   virtual double getTickStep(const QCPRange &range);
   virtual int getSubTickCount(double tickStep);
@@ -1741,7 +1807,7 @@ public:
   QCPAxisTickerText();
   
   // getters:
-  QMap<double, QString> &ticks() { return mTicks; }
+  QMap<double, QString> &ticks() { ++mRevision; return mTicks; }
   int subTickCount() const { return mSubTickCount; }
   
   // setters:
@@ -2176,6 +2242,10 @@ protected:
   QVector<double> mSubTickVector;
   bool mCachedMarginValid;
   int mCachedMargin;
+  QCPAxisTicker *mTickVectorTicker; // ticker, ticker revision and parameters the tick vectors were generated with
+  int mTickVectorRevision;
+  QVector<double> mTickVectorState;
+  QLocale mTickVectorLocale;
   bool mDragging;
   QCPRange mDragStartRange;
   QCP::AntialiasedElements mAADragBackup, mNotAADragBackup;
@@ -2376,6 +2446,7 @@ public:
   void applyTo(QCPPainter *painter, const QPen &defaultPen) const;
   void drawShape(QCPPainter *painter, const QPointF &pos) const;
   void drawShape(QCPPainter *painter, double x, double y) const;
+  void drawShapes(QCPPainter *painter, const QVector<QPointF> &points) const;
 
 protected:
   // property members:
@@ -2388,6 +2459,9 @@ protected:
   
   // non-property members:
   bool mPenDefined;
+  
+  // non-virtual methods:
+  QImage shapeSprite(QCPPainter *painter, QPointF *center) const;
 };
 Q_DECLARE_TYPEINFO(QCPScatterStyle, Q_MOVABLE_TYPE);
 Q_DECLARE_OPERATORS_FOR_FLAGS(QCPScatterStyle::ScatterProperties)
@@ -2421,9 +2495,13 @@ public:
   int size() const { return mData.size()-mPreallocSize; }
   bool isEmpty() const { return size() == 0; }
   bool autoSqueeze() const { return mAutoSqueeze; }
+  int capacity() const { return mCapacity; }
+  int revision() const { return mRevision; }
+  qint64 dropOffset() const { return mDropOffset; }
   
   // setters:
   void setAutoSqueeze(bool enabled);
+  void setCapacity(int capacity);
   
   // non-virtual methods:
   void set(const QCPDataContainer<DataType> &data);
@@ -2441,8 +2519,8 @@ public:
   
   const_iterator constBegin() const { return mData.constBegin()+mPreallocSize; }
   const_iterator constEnd() const { return mData.constEnd(); }
-  iterator begin() { return mData.begin()+mPreallocSize; }
-  iterator end() { return mData.end(); }
+  iterator begin() { invalidateRangeCache(); return mData.begin()+mPreallocSize; }
+  iterator end() { invalidateRangeCache(); return mData.end(); }
   const_iterator findBegin(double sortKey, bool expandedRange=true) const;
   const_iterator findEnd(double sortKey, bool expandedRange=true) const;
   const_iterator at(int index) const { return constBegin()+qBound(0, index, size()); }
@@ -2454,15 +2532,25 @@ public:
 protected:
   // property members:
   bool mAutoSqueeze;
+  int mCapacity;
   
   // non-property memebers:
   QVector<DataType> mData;
   int mPreallocSize;
   int mPreallocIteration;
+  int mRevision;
+  qint64 mDropOffset;
+  struct RangeCache { QCPRange range; bool haveLower, haveUpper, valid; };
+  RangeCache mKeyRangeCache[3], mValueRangeCache[3]; // indexed by QCP::SignDomain, for keyRange/valueRange over all data
   
   // non-virtual methods:
   void preallocateGrow(int minimumPreallocSize);
   void performAutoSqueeze();
+  void enforceCapacity();
+  void invalidateRangeCache();
+  void expandRangeCache(const DataType &data);
+  void shrinkRangeCache(const DataType &data);
+  static void expandRange(RangeCache &cache, double lower, double upper, QCP::SignDomain signDomain);
 };
 
 // include implementation in header since it is a class template:
@@ -2503,6 +2591,16 @@ protected:
   sort. Failing to do so can not be detected by the container efficiently and will cause both
   rendering artifacts and potential data loss.
 
+  The ranges returned by \ref keyRange and by \ref valueRange without key restriction are cached
+  per sign domain. Adding data only expands the cached ranges by the added points, so repeatedly
+  rescaling axes while data is streamed in costs constant time per added point instead of a scan
+  over all data. Removing data, \ref set, \ref sort and obtaining non-const iterators (\ref begin,
+  \ref end) discard the cache, the next range query then scans the data once.
+
+  For monitoring applications that only display the most recent data, \ref setCapacity turns the
+  container into a sliding window of fixed size: adding data drops the oldest points as soon as
+  the capacity is exceeded, and the memory stays constant over any run time.
+
   Implementing one-dimensional plottables that make use of a \ref QCPDataContainer<T> is usually
   done by subclassing from \ref QCPAbstractPlottable1D "QCPAbstractPlottable1D<T>", which
   introduces an according \a mDataContainer member and some convenience methods.
@@ -2591,6 +2689,28 @@ protected:
   dataselection-accessing "data selection page" for an example.
 */
 
+/*! \fn int QCPDataContainer::revision() const
+
+  Returns a counter that changes whenever data points already in this container may have been
+  modified, removed or moved to a different index, e.g. by \ref remove, \ref set, a non-appending
+  \ref add or by obtaining non-const iterators. Appending data points with keys greater than or
+  equal to the existing ones leaves it unchanged. So does dropping the oldest data points when the
+  capacity is exceeded (\ref setCapacity), that only advances the \ref dropOffset.
+
+  Classes that keep auxiliary data derived from the container (e.g. the sampling index of \ref
+  QCPGraph) can use this to extend that data incrementally as long as only appends happened.
+*/
+
+/*! \fn qint64 QCPDataContainer::dropOffset() const
+
+  Returns the total number of data points that were dropped from the front of this container
+  because its capacity was exceeded (\ref setCapacity).
+
+  As long as the \ref revision stays the same, a data point that had index \a i when the drop
+  offset was \a d has index <tt>i+d-dropOffset()</tt> now, if it wasn't dropped yet. Auxiliary data
+  that is indexed by <tt>index+dropOffset()</tt> thus stays valid while the window slides.
+*/
+
 /*! \fn QCPDataRange QCPDataContainer::dataRange() const
 
   Returns a \ref QCPDataRange encompassing the entire data set of this container. This means the
@@ -2606,9 +2726,13 @@ protected:
 template <class DataType>
 QCPDataContainer<DataType>::QCPDataContainer() :
   mAutoSqueeze(true),
+  mCapacity(0),
   mPreallocSize(0),
-  mPreallocIteration(0)
+  mPreallocIteration(0),
+  mRevision(0),
+  mDropOffset(0)
 {
+  invalidateRangeCache();
 }
 
 /*!
@@ -2630,6 +2754,43 @@ void QCPDataContainer<DataType>::setAutoSqueeze(bool enabled)
   }
 }
 
+/*!
+  Limits the container to the \a capacity data points with the largest (sort-)keys, turning it into
+  a sliding window over streamed data. A \a capacity of 0 (the default) removes the limit.
+
+  Once the container holds \a capacity data points, each added point drops the oldest one. The
+  data stays in one contiguous block, so iterators, \ref findBegin and \ref findEnd work as usual.
+  Internally, memory for twice the capacity is allocated once: dropped points are only skipped
+  (like with \ref removeBefore), and when the window reaches the end of the allocation, it is
+  moved back to its start. Added data points with keys smaller than all existing ones are only
+  kept as far as there is room left below the capacity, the others are discarded right away.
+
+  Adding a data point thus costs constant time on average, and the container never reallocates as
+  long as single adds and batches smaller than \a capacity are used. Dropping data points doesn't
+  change the \ref revision, but advances the \ref dropOffset, and the cached ranges of \ref
+  keyRange and \ref valueRange are only discarded when a dropped point lay on their bounds.
+  Automatic squeezing (\ref setAutoSqueeze) is suspended while a capacity is set.
+
+  If the container currently holds more data points than \a capacity, the oldest ones are removed.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::setCapacity(int capacity)
+{
+  mCapacity = qMax(0, capacity);
+  if (mCapacity > 0)
+  {
+    QVector<DataType> window;
+    window.reserve(2*mCapacity);
+    window.resize(qMin(size(), mCapacity));
+    std::copy(constEnd()-window.size(), constEnd(), window.begin());
+    mData.swap(window);
+    mPreallocSize = 0;
+    mPreallocIteration = 0;
+    invalidateRangeCache();
+  } else if (mAutoSqueeze)
+    performAutoSqueeze();
+}
+
 /*! \overload
   
   Replaces the current data in this container with the provided \a data.
@@ -2655,9 +2816,16 @@ void QCPDataContainer<DataType>::set(const QCPDataContainer<DataType> &data)
 template <class DataType>
 void QCPDataContainer<DataType>::set(const QVector<DataType> &data, bool alreadySorted)
 {
+  if (mCapacity > 0) // keep the preallocated window instead of sharing the buffer of data
+  {
+    clear();
+    add(data, alreadySorted);
+    return;
+  }
   mData = data;
   mPreallocSize = 0;
   mPreallocIteration = 0;
+  invalidateRangeCache();
   if (!alreadySorted)
     sort();
 }
@@ -2674,22 +2842,37 @@ void QCPDataContainer<DataType>::add(const QCPDataContainer<DataType> &data)
   if (data.isEmpty())
     return;
   
-  const int n = data.size();
+  int n = data.size();
   const int oldSize = size();
   
   if (oldSize > 0 && !qcpLessThanSortKey<DataType>(*constBegin(), *(data.constEnd()-1))) // prepend if new data keys are all smaller than or equal to existing ones
   {
+    if (mCapacity > 0) // the sliding window only keeps the points with the largest keys, which are at the end of data
+    {
+      n = qMin(n, mCapacity-oldSize);
+      if (n <= 0)
+        return;
+    }
     if (mPreallocSize < n)
       preallocateGrow(n);
     mPreallocSize -= n;
-    std::copy(data.constBegin(), data.constEnd(), begin());
+    std::copy(data.constEnd()-n, data.constEnd(), mData.begin()+mPreallocSize);
+    ++mRevision;
   } else // don't need to prepend, so append and merge if necessary
   {
+    if (mCapacity > 0 && mData.size()+n > mData.capacity()) // make room at the end of the sliding window instead of reallocating
+      squeeze(true, false);
     mData.resize(mData.size()+n);
-    std::copy(data.constBegin(), data.constEnd(), end()-n);
+    std::copy(data.constBegin(), data.constEnd(), mData.end()-n);
     if (oldSize > 0 && !qcpLessThanSortKey<DataType>(*(constEnd()-n-1), *(constEnd()-n))) // if appended range keys aren't all greater than existing ones, merge the two partitions
-      std::inplace_merge(begin(), end()-n, end(), qcpLessThanSortKey<DataType>);
+    {
+      std::inplace_merge(mData.begin()+mPreallocSize, mData.end()-n, mData.end(), qcpLessThanSortKey<DataType>);
+      ++mRevision;
+    }
   }
+  for (const_iterator it = data.constEnd()-n; it != data.constEnd(); ++it)
+    expandRangeCache(*it);
+  enforceCapacity();
 }
 
 /*!
@@ -2705,30 +2888,45 @@ void QCPDataContainer<DataType>::add(const QVector<DataType> &data, bool already
 {
   if (data.isEmpty())
     return;
-  if (isEmpty())
+  if (isEmpty() && mCapacity <= 0)
   {
     set(data, alreadySorted);
     return;
   }
   
-  const int n = data.size();
+  int n = data.size();
   const int oldSize = size();
   
   if (alreadySorted && oldSize > 0 && !qcpLessThanSortKey<DataType>(*constBegin(), *(data.constEnd()-1))) // prepend if new data is sorted and keys are all smaller than or equal to existing ones
   {
+    if (mCapacity > 0) // the sliding window only keeps the points with the largest keys, which are at the end of data
+    {
+      n = qMin(n, mCapacity-oldSize);
+      if (n <= 0)
+        return;
+    }
     if (mPreallocSize < n)
       preallocateGrow(n);
     mPreallocSize -= n;
-    std::copy(data.constBegin(), data.constEnd(), begin());
+    std::copy(data.constEnd()-n, data.constEnd(), mData.begin()+mPreallocSize);
+    ++mRevision;
   } else // don't need to prepend, so append and then sort and merge if necessary
   {
+    if (mCapacity > 0 && mData.size()+n > mData.capacity()) // make room at the end of the sliding window instead of reallocating
+      squeeze(true, false);
     mData.resize(mData.size()+n);
-    std::copy(data.constBegin(), data.constEnd(), end()-n);
+    std::copy(data.constBegin(), data.constEnd(), mData.end()-n);
     if (!alreadySorted) // sort appended subrange if it wasn't already sorted
-      std::sort(end()-n, end(), qcpLessThanSortKey<DataType>);
+      std::sort(mData.end()-n, mData.end(), qcpLessThanSortKey<DataType>);
     if (oldSize > 0 && !qcpLessThanSortKey<DataType>(*(constEnd()-n-1), *(constEnd()-n))) // if appended range keys aren't all greater than existing ones, merge the two partitions
-      std::inplace_merge(begin(), end()-n, end(), qcpLessThanSortKey<DataType>);
+    {
+      std::inplace_merge(mData.begin()+mPreallocSize, mData.end()-n, mData.end(), qcpLessThanSortKey<DataType>);
+      ++mRevision;
+    }
   }
+  for (const_iterator it = data.constEnd()-n; it != data.constEnd(); ++it)
+    expandRangeCache(*it);
+  enforceCapacity();
 }
 
 /*! \overload
@@ -2745,15 +2943,21 @@ void QCPDataContainer<DataType>::add(const DataType &data)
     mData.append(data);
   } else if (qcpLessThanSortKey<DataType>(data, *constBegin()))  // quickly handle prepends using preallocated space
   {
+    if (mCapacity > 0 && size() >= mCapacity) // the full sliding window would drop the point right away
+      return;
     if (mPreallocSize < 1)
       preallocateGrow(1);
     --mPreallocSize;
-    *begin() = data;
+    mData[mPreallocSize] = data;
+    ++mRevision;
   } else // handle inserts, maintaining sorted keys
   {
-    QCPDataContainer<DataType>::iterator insertionPoint = std::lower_bound(begin(), end(), data, qcpLessThanSortKey<DataType>);
+    QCPDataContainer<DataType>::iterator insertionPoint = std::lower_bound(mData.begin()+mPreallocSize, mData.end(), data, qcpLessThanSortKey<DataType>);
     mData.insert(insertionPoint, data);
+    ++mRevision;
   }
+  expandRangeCache(data);
+  enforceCapacity();
 }
 
 /*!
@@ -2767,6 +2971,7 @@ void QCPDataContainer<DataType>::removeBefore(double sortKey)
   QCPDataContainer<DataType>::iterator it = begin();
   QCPDataContainer<DataType>::iterator itEnd = std::lower_bound(begin(), end(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
   mPreallocSize += itEnd-it; // don't actually delete, just add it to the preallocated block (if it gets too large, squeeze will take care of it)
+  invalidateRangeCache();
   if (mAutoSqueeze)
     performAutoSqueeze();
 }
@@ -2782,6 +2987,7 @@ void QCPDataContainer<DataType>::removeAfter(double sortKey)
   QCPDataContainer<DataType>::iterator it = std::upper_bound(begin(), end(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
   QCPDataContainer<DataType>::iterator itEnd = end();
   mData.erase(it, itEnd); // typically adds it to the postallocated block
+  invalidateRangeCache();
   if (mAutoSqueeze)
     performAutoSqueeze();
 }
@@ -2802,6 +3008,7 @@ void QCPDataContainer<DataType>::remove(double sortKeyFrom, double sortKeyTo)
   QCPDataContainer<DataType>::iterator it = std::lower_bound(begin(), end(), DataType::fromSortKey(sortKeyFrom), qcpLessThanSortKey<DataType>);
   QCPDataContainer<DataType>::iterator itEnd = std::upper_bound(it, end(), DataType::fromSortKey(sortKeyTo), qcpLessThanSortKey<DataType>);
   mData.erase(it, itEnd);
+  invalidateRangeCache();
   if (mAutoSqueeze)
     performAutoSqueeze();
 }
@@ -2825,6 +3032,7 @@ void QCPDataContainer<DataType>::remove(double sortKey)
       ++mPreallocSize; // don't actually delete, just add it to the preallocated block (if it gets too large, squeeze will take care of it)
     else
       mData.erase(it);
+    invalidateRangeCache();
   }
   if (mAutoSqueeze)
     performAutoSqueeze();
@@ -2841,6 +3049,7 @@ void QCPDataContainer<DataType>::clear()
   mData.clear();
   mPreallocIteration = 0;
   mPreallocSize = 0;
+  invalidateRangeCache();
 }
 
 /*!
@@ -2877,7 +3086,7 @@ void QCPDataContainer<DataType>::squeeze(bool preAllocation, bool postAllocation
   {
     if (mPreallocSize > 0)
     {
-      std::copy(begin(), end(), mData.begin());
+      std::copy(mData.begin()+mPreallocSize, mData.end(), mData.begin());
       mData.resize(size());
       mPreallocSize = 0;
     }
@@ -2964,6 +3173,12 @@ QCPRange QCPDataContainer<DataType>::keyRange(bool &foundRange, QCP::SignDomain
     foundRange = false;
     return QCPRange();
   }
+  RangeCache &cache = mKeyRangeCache[signDomain];
+  if (cache.valid)
+  {
+    foundRange = cache.haveLower && cache.haveUpper;
+    return cache.range;
+  }
   QCPRange range;
   bool haveLower = false;
   bool haveUpper = false;
@@ -3059,6 +3274,10 @@ QCPRange QCPDataContainer<DataType>::keyRange(bool &foundRange, QCP::SignDomain
     }
   }
   
+  cache.range = range;
+  cache.haveLower = haveLower;
+  cache.haveUpper = haveUpper;
+  cache.valid = true;
   foundRange = haveLower && haveUpper;
   return range;
 }
@@ -3087,8 +3306,13 @@ QCPRange QCPDataContainer<DataType>::valueRange(bool &foundRange, QCP::SignDomai
     foundRange = false;
     return QCPRange();
   }
-  QCPRange range;
   const bool restrictKeyRange = inKeyRange != QCPRange();
+  if (!restrictKeyRange && mValueRangeCache[signDomain].valid)
+  {
+    foundRange = mValueRangeCache[signDomain].haveLower && mValueRangeCache[signDomain].haveUpper;
+    return mValueRangeCache[signDomain].range;
+  }
+  QCPRange range;
   bool haveLower = false;
   bool haveUpper = false;
   QCPRange current;
@@ -3155,6 +3379,14 @@ QCPRange QCPDataContainer<DataType>::valueRange(bool &foundRange, QCP::SignDomai
     }
   }
   
+  if (!restrictKeyRange)
+  {
+    RangeCache &cache = mValueRangeCache[signDomain];
+    cache.range = range;
+    cache.haveLower = haveLower;
+    cache.haveUpper = haveUpper;
+    cache.valid = true;
+  }
   foundRange = haveLower && haveUpper;
   return range;
 }
@@ -3192,8 +3424,11 @@ void QCPDataContainer<DataType>::preallocateGrow(int minimumPreallocSize)
     return;
   
   int newPreallocSize = minimumPreallocSize;
-  newPreallocSize += (1u<<qBound(4, mPreallocIteration+4, 15)) - 12; // do 4 up to 32768-12 preallocation, doubling in each intermediate iteration
-  ++mPreallocIteration;
+  if (mCapacity <= 0) // the sliding window only moves its data within its fixed allocation, see setCapacity
+  {
+    newPreallocSize += (1u<<qBound(4, mPreallocIteration+4, 15)) - 12; // do 4 up to 32768-12 preallocation, doubling in each intermediate iteration
+    ++mPreallocIteration;
+  }
   
   int sizeDifference = newPreallocSize-mPreallocSize;
   mData.resize(mData.size()+sizeDifference);
@@ -3218,6 +3453,8 @@ void QCPDataContainer<DataType>::preallocateGrow(int minimumPreallocSize)
 template <class DataType>
 void QCPDataContainer<DataType>::performAutoSqueeze()
 {
+  if (mCapacity > 0) // the sliding window manages its fixed allocation itself, see enforceCapacity
+    return;
   const int totalAlloc = mData.capacity();
   const int postAllocSize = totalAlloc-mData.size();
   const int usedSize = size();
@@ -3236,6 +3473,116 @@ void QCPDataContainer<DataType>::performAutoSqueeze()
   if (shrinkPreAllocation || shrinkPostAllocation)
     squeeze(shrinkPreAllocation, shrinkPostAllocation);
 }
+
+/*! \internal
+
+  If a capacity is set (\ref setCapacity) and exceeded, drops the oldest data points by moving them
+  to the preallocation pool. Once the window has advanced to the end of the fixed allocation of
+  twice the capacity, it is moved back to the start of the allocation.
+
+  Dropping keeps the indices of the remaining data points relative to the \ref dropOffset, so it
+  doesn't advance the \ref revision.
+
+  Called at the end of every method that adds data.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::enforceCapacity()
+{
+  if (mCapacity <= 0)
+    return;
+  if (size() > mCapacity)
+  {
+    const int dropCount = size()-mCapacity;
+    for (const_iterator it = constBegin(); it != constBegin()+dropCount; ++it)
+      shrinkRangeCache(*it);
+    mPreallocSize += dropCount;
+    mDropOffset += dropCount;
+  }
+  if (mData.size() >= 2*mCapacity)
+    squeeze(true, false);
+}
+
+/*! \internal
+  
+  Discards the cached results of \ref keyRange and \ref valueRange. The next call of either method
+  determines the range from the data again. Since this is called whenever existing data may change,
+  it also advances the \ref revision.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::invalidateRangeCache()
+{
+  ++mRevision;
+  for (int i=0; i<3; ++i)
+  {
+    mKeyRangeCache[i].valid = false;
+    mValueRangeCache[i].valid = false;
+  }
+}
+
+/*! \internal
+  
+  Expands the valid cached ranges of \ref keyRange and \ref valueRange such that they include the
+  newly added data point \a data. Since adding data can only widen the ranges, the caches stay
+  exact and don't need to be invalidated.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::expandRangeCache(const DataType &data)
+{
+  const QCPRange valueRange = data.valueRange();
+  const bool hasValue = !qIsNaN(data.mainValue());
+  for (int i=0; i<3; ++i)
+  {
+    if (mKeyRangeCache[i].valid && hasValue)
+      expandRange(mKeyRangeCache[i], data.mainKey(), data.mainKey(), QCP::SignDomain(i));
+    if (mValueRangeCache[i].valid)
+      expandRange(mValueRangeCache[i], valueRange.lower, valueRange.upper, QCP::SignDomain(i));
+  }
+}
+
+/*! \internal
+  
+  Keeps the valid cached ranges of \ref keyRange and \ref valueRange exact when the data point \a
+  data is dropped from the container. Only the caches that have a bound at the coordinates of \a
+  data are discarded, the others can't have been affected by it.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::shrinkRangeCache(const DataType &data)
+{
+  const QCPRange valueRange = data.valueRange();
+  const bool hasValue = !qIsNaN(data.mainValue());
+  for (int i=0; i<3; ++i)
+  {
+    RangeCache &keyCache = mKeyRangeCache[i];
+    if (keyCache.valid && hasValue && ((keyCache.haveLower && data.mainKey() == keyCache.range.lower) || (keyCache.haveUpper && data.mainKey() == keyCache.range.upper)))
+      keyCache.valid = false;
+    RangeCache &valueCache = mValueRangeCache[i];
+    if (valueCache.valid && ((valueCache.haveLower && (valueRange.lower == valueCache.range.lower || valueRange.upper == valueCache.range.lower)) ||
+                             (valueCache.haveUpper && (valueRange.lower == valueCache.range.upper || valueRange.upper == valueCache.range.upper))))
+      valueCache.valid = false;
+  }
+}
+
+/*! \internal
+  
+  Widens the range held by \a cache to include \a lower and \a upper, applying the same NaN and
+  sign domain rules as the scans in \ref keyRange and \ref valueRange.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::expandRange(RangeCache &cache, double lower, double upper, QCP::SignDomain signDomain)
+{
+  if ((lower < cache.range.lower || !cache.haveLower) && !qIsNaN(lower) &&
+      (signDomain == QCP::sdBoth || (signDomain == QCP::sdNegative && lower < 0) || (signDomain == QCP::sdPositive && lower > 0)))
+  {
+    cache.range.lower = lower;
+    cache.haveLower = true;
+  }
+  if ((upper > cache.range.upper || !cache.haveUpper) && !qIsNaN(upper) &&
+      (signDomain == QCP::sdBoth || (signDomain == QCP::sdNegative && upper < 0) || (signDomain == QCP::sdPositive && upper > 0)))
+  {
+    cache.range.upper = upper;
+    cache.haveUpper = true;
+  }
+}
 /* end of 'src/datacontainer.cpp' */
 
 
@@ -3587,6 +3934,37 @@ private:
 /* including file 'src/core.h', size 14886                                   */
 /* commit ce344b3f96a62e5f652585e55f1ae7c7883cd45b 2018-06-25 01:03:39 +0200 */
 
+class QCP_LIB_DECL QCPReplotProfile
+{
+public:
+  /*!
+    Defines which part of a replot an \ref Entry measured.
+  */
+  enum EntryType { etLayout     ///< Updating the layout of the plot, which includes the tick calculation of the axes
+                   ,etLayer     ///< Drawing a layer with all its layerables into its paint buffer
+                   ,etLayerable ///< Drawing a single layerable, e.g. an axis, a plottable or an item
+                 };
+  
+  class Entry
+  {
+  public:
+    Entry() : type(etLayerable), start(0), duration(0), points(0), thread(0) {}
+    
+    EntryType type;
+    QString name;
+    double start, duration;
+    int points;
+    int thread;
+  };
+  
+  QCPReplotProfile() : start(0), duration(0), full(true) {}
+  
+  double start, duration;
+  bool full;
+  QVector<Entry> entries;
+};
+Q_DECLARE_TYPEINFO(QCPReplotProfile::Entry, Q_MOVABLE_TYPE);
+
 class QCP_LIB_DECL QCustomPlot : public QWidget
 {
   Q_OBJECT
@@ -3601,6 +3979,11 @@ class QCP_LIB_DECL QCustomPlot : public QWidget
   Q_PROPERTY(bool noAntialiasingOnDrag READ noAntialiasingOnDrag WRITE setNoAntialiasingOnDrag)
   Q_PROPERTY(Qt::KeyboardModifier multiSelectModifier READ multiSelectModifier WRITE setMultiSelectModifier)
   Q_PROPERTY(bool openGl READ openGl WRITE setOpenGl)
+  Q_PROPERTY(bool threadedReplot READ threadedReplot WRITE setThreadedReplot)
+  Q_PROPERTY(int replotTiles READ replotTiles WRITE setReplotTiles)
+  Q_PROPERTY(double maxFrameRate READ maxFrameRate WRITE setMaxFrameRate)
+  Q_PROPERTY(int profilerFrames READ profilerFrames WRITE setProfilerFrames)
+  Q_PROPERTY(bool profilerOverlay READ profilerOverlay WRITE setProfilerOverlay)
   /// \endcond
 public:
   /*!
@@ -3646,6 +4029,11 @@ public:
   QCP::SelectionRectMode selectionRectMode() const { return mSelectionRectMode; }
   QCPSelectionRect *selectionRect() const { return mSelectionRect; }
   bool openGl() const { return mOpenGl; }
+  bool threadedReplot() const { return mThreadedReplot; }
+  int replotTiles() const { return mReplotTiles; }
+  double maxFrameRate() const { return mMaxFrameRate; }
+  int profilerFrames() const { return mProfilerFrames; }
+  bool profilerOverlay() const { return mProfilerOverlay; }
   
   // setters:
   void setViewport(const QRect &rect);
@@ -3670,6 +4058,11 @@ public:
   void setSelectionRectMode(QCP::SelectionRectMode mode);
   void setSelectionRect(QCPSelectionRect *selectionRect);
   void setOpenGl(bool enabled, int multisampling=16);
+  void setThreadedReplot(bool enabled);
+  void setReplotTiles(int tiles);
+  void setMaxFrameRate(double framesPerSecond);
+  void setProfilerFrames(int frames);
+  void setProfilerOverlay(bool enabled);
   
   // non-property methods:
   // plottable interface:
@@ -3692,6 +4085,8 @@ public:
   int clearGraphs();
   int graphCount() const;
   QList<QCPGraph*> selectedGraphs() const;
+  void addGraphData(double key, const double *values, int count);
+  void addGraphData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
 
   // item interface:
   QCPAbstractItem *item(int index) const;
@@ -3735,6 +4130,11 @@ public:
   QPixmap toPixmap(int width=0, int height=0, double scale=1.0);
   void toPainter(QCPPainter *painter, int width=0, int height=0);
   Q_SLOT void replot(QCustomPlot::RefreshPriority refreshPriority=QCustomPlot::rpRefreshHint);
+  void invalidatePaintBuffers();
+  double replotTime(bool average=false) const;
+  double frameRate() const;
+  QList<QCPReplotProfile> replotProfiles() const { return mReplotProfiles; }
+  bool saveProfilerTrace(const QString &fileName) const;
   
   QCPAxis *xAxis, *yAxis, *xAxis2, *yAxis2;
   QCPLegend *legend;
@@ -3760,6 +4160,8 @@ signals:
   void afterReplot();
   
 protected:
+  class LayerGroupTask;
+  
   // property members:
   QRect mViewport;
   double mBufferDevicePixelRatio;
@@ -3784,6 +4186,11 @@ protected:
   QCP::SelectionRectMode mSelectionRectMode;
   QCPSelectionRect *mSelectionRect;
   bool mOpenGl;
+  bool mThreadedReplot;
+  int mReplotTiles;
+  double mMaxFrameRate;
+  int mProfilerFrames;
+  bool mProfilerOverlay;
   
   // non-property members:
   QList<QSharedPointer<QCPAbstractPaintBuffer> > mPaintBuffers;
@@ -3795,6 +4202,17 @@ protected:
   QVariant mMouseSignalLayerableDetails;
   bool mReplotting;
   bool mReplotQueued;
+  QVector<double> mReplotState; // viewport and axis ranges of the last full replot, see replotState
+  QElapsedTimer mFrameTimer;
+  qint64 mLastReplotStart; // in nanoseconds of mFrameTimer, -1 before the first replot
+  double mReplotTime, mReplotTimeAverage, mReplotIntervalAverage; // in milliseconds
+  bool mDragDegraded; // antialiasing is disabled because replots exceeded the frame budget while dragging
+  QCP::AntialiasedElements mDragDegradedAABackup, mDragDegradedNotAABackup;
+  QList<QCPReplotProfile> mReplotProfiles; // the last mProfilerFrames profiles, oldest first
+  QCPReplotProfile mCurrentProfile;
+  qint64 mProfileStart; // in nanoseconds of mFrameTimer, -1 while no replot is profiled
+  QList<Qt::HANDLE> mProfileThreads; // index is the thread number of the profile entries
+  QMutex mProfileMutex; // guards mCurrentProfile and mProfileThreads while layers are drawn concurrently
   int mOpenGlMultisamples;
   QCP::AntialiasedElements mOpenGlAntialiasedElementsBackup;
   bool mOpenGlCacheLabelsBackup;
@@ -3834,7 +4252,15 @@ protected:
   void drawBackground(QCPPainter *painter);
   void setupPaintBuffers();
   QCPAbstractPaintBuffer *createPaintBuffer();
+  void drawLayers(const QList<QCPLayer*> &layers);
+  static void drawLayerGroup(const QList<QCPLayer*> &layers);
   bool hasInvalidatedPaintBuffers();
+  QVector<double> replotState() const;
+  void addGraphRows(const double *keys, int keyCount, const double *values, int valueCount, bool alreadySorted);
+  void beginProfile();
+  void endProfile(bool full);
+  void addProfileEntry(QCPReplotProfile::EntryType type, const QString &name, qint64 start, int points=0);
+  void drawProfilerOverlay(QCPPainter *painter);
   bool setupOpenGl();
   void freeOpenGl();
   
@@ -5169,6 +5595,8 @@ class QCP_LIB_DECL QCPGraph : public QCPAbstractPlottable1D<QCPGraphData>
   Q_PROPERTY(int scatterSkip READ scatterSkip WRITE setScatterSkip)
   Q_PROPERTY(QCPGraph* channelFillGraph READ channelFillGraph WRITE setChannelFillGraph)
   Q_PROPERTY(bool adaptiveSampling READ adaptiveSampling WRITE setAdaptiveSampling)
+  Q_PROPERTY(bool adaptiveSamplingIndex READ adaptiveSamplingIndex WRITE setAdaptiveSamplingIndex)
+  Q_PROPERTY(bool incrementalDrawing READ incrementalDrawing WRITE setIncrementalDrawing)
   /// \endcond
 public:
   /*!
@@ -5196,6 +5624,8 @@ public:
   int scatterSkip() const { return mScatterSkip; }
   QCPGraph *channelFillGraph() const { return mChannelFillGraph.data(); }
   bool adaptiveSampling() const { return mAdaptiveSampling; }
+  bool adaptiveSamplingIndex() const { return mAdaptiveSamplingIndex; }
+  bool incrementalDrawing() const { return mIncrementalDrawing; }
   
   // setters:
   void setData(QSharedPointer<QCPGraphDataContainer> data);
@@ -5205,12 +5635,15 @@ public:
   void setScatterSkip(int skip);
   void setChannelFillGraph(QCPGraph *targetGraph);
   void setAdaptiveSampling(bool enabled);
+  void setAdaptiveSamplingIndex(bool enabled);
+  void setIncrementalDrawing(bool enabled);
   
   // non-property methods:
   void addData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
   void addData(double key, double value);
   
   // reimplemented virtual methods:
+  virtual QCPDataSelection selectTestRect(const QRectF &rect, bool onlySelectable) const Q_DECL_OVERRIDE;
   virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=0) const Q_DECL_OVERRIDE;
   virtual QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const Q_DECL_OVERRIDE;
   virtual QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth, const QCPRange &inKeyRange=QCPRange()) const Q_DECL_OVERRIDE;
@@ -5222,6 +5655,25 @@ protected:
   int mScatterSkip;
   QPointer<QCPGraph> mChannelFillGraph;
   bool mAdaptiveSampling;
+  bool mAdaptiveSamplingIndex;
+  bool mIncrementalDrawing;
+  
+  // non-property members:
+  struct ValueSpan { double min, max; };
+  mutable QVector<QVector<ValueSpan> > mSamplingIndex; // level i holds the value span of each block of 8<<i data points
+  mutable const QCPGraphDataContainer *mSamplingIndexContainer;
+  mutable int mSamplingIndexRevision;
+  mutable qint64 mSamplingIndexOffset; // drop offset of the data container when the index was started
+  mutable int mSamplingIndexShift; // position in the index of the data point with index 0
+  mutable int mSamplingIndexCount;
+  QImage mIncrementalRaster; // the graph as drawn up to the data point at mIncrementalLastKey, see drawIncremental
+  QVector<double> mIncrementalState;
+  QPen mIncrementalPen;
+  const QCPGraphDataContainer *mIncrementalContainer;
+  int mIncrementalRevision;
+  qint64 mIncrementalDropOffset;
+  double mIncrementalRefKey, mIncrementalRefPixel; // a key coordinate and its pixel position in the raster
+  double mIncrementalLastKey, mIncrementalLastValue;
   
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
@@ -5237,6 +5689,9 @@ protected:
   virtual void getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGraphDataContainer::const_iterator begin, QCPGraphDataContainer::const_iterator end) const;
   
   // non-virtual methods:
+  void drawSegments(QCPPainter *painter);
+  bool drawIncremental(QCPPainter *painter);
+  static void scrollImage(QImage *image, int dx, int dy);
   void getVisibleDataBounds(QCPGraphDataContainer::const_iterator &begin, QCPGraphDataContainer::const_iterator &end, const QCPDataRange &rangeRestriction) const;
   void getLines(QVector<QPointF> *lines, const QCPDataRange &dataRange) const;
   void getScatters(QVector<QPointF> *scatters, const QCPDataRange &dataRange) const;
@@ -5256,6 +5711,10 @@ protected:
   int findIndexBelowY(const QVector<QPointF> *data, double y) const;
   int findIndexAboveY(const QVector<QPointF> *data, double y) const;
   double pointDistance(const QPointF &pixelPoint, QCPGraphDataContainer::const_iterator &closestData) const;
+  double lineDistanceSqr(const QPointF &pixelPoint, const QCPDataRange &dataRange) const;
+  double indexedLineDistanceSqr(const QPointF &pixelPoint, int begin, int end, int lastIndex, double minDistSqr) const;
+  void updateSamplingIndex() const;
+  void getSamplingIndexSpan(int begin, int end, double &minValue, double &maxValue) const;
   
   friend class QCustomPlot;
   friend class QCPLegend;
@@ -5738,6 +6197,7 @@ protected:
   unsigned char *mAlpha;
   QCPRange mDataBounds;
   bool mDataModified;
+  QRect mModifiedCells;
   
   bool createAlpha(bool initializeOpaque=true);
   
@@ -5806,6 +6266,7 @@ protected:
   QImage mMapImage, mUndersampledMapImage;
   QPixmap mLegendIcon;
   bool mMapImageInvalidated;
+  Qt::Orientation mMapImageOrientation;
   
   // introduced virtual methods:
   virtual void updateMapImage();
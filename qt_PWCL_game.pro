@@ -21,7 +21,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui serialport multimedia
+QT       += core gui serialport multimedia concurrent
 win32:RC_ICONS += gator_icon.ico
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
@@ -49,16 +49,20 @@ include(./QXlsx.pri)
 
 SOURCES += \
         about.cpp \
+        autosave.cpp \
         main.cpp \
         mainwindow.cpp \
         port.cpp \
-        qcustomplot.cpp
+        qcustomplot.cpp \
+        sessiondensity.cpp
 
 HEADERS += \
         about.h \
+        autosave.h \
         mainwindow.h \
         port.h \
-        qcustomplot.h
+        qcustomplot.h \
+        sessiondensity.h
 
 FORMS += \
         about.ui \
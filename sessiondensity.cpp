@@ -0,0 +1,171 @@
+/*
+Copyright (C) 2019  Anthony Arrowood
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "sessiondensity.h"
+#include "qcustomplot.h"
+
+#include <QDir>
+#include <QFile>
+#include <QStatusBar>
+#include <QtConcurrent>
+
+/**
+ * Counts the samples of one session csv file into DENSITY_TIME_CELLS x DENSITY_TEMP_CELLS cells,
+ * stored row by row with one row per temperature cell.
+ * Samples outside the image are dropped. Returns an empty histogram if the file can't be read.
+ */
+struct CountSession
+{
+    typedef QVector<quint32> result_type;
+
+    QVector<quint32> operator()(const QString &csvPath) const
+    {
+        QFile file(csvPath);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            return QVector<quint32>();
+
+        QVector<quint32> counts(DENSITY_TIME_CELLS * DENSITY_TEMP_CELLS, 0);
+        file.readLine();  // column headers
+        while (!file.atEnd()) {
+            // Time, Percent on, Temperature, ...
+            const QList<QByteArray> fields = file.readLine().split(',');
+            if (fields.size() < 3)
+                continue;
+            bool timeOk = false;
+            bool tempOk = false;
+            const double time = fields[0].trimmed().toDouble(&timeOk);
+            const double temp = fields[2].trimmed().toDouble(&tempOk);
+            if (!timeOk || !tempOk)
+                continue;
+
+            // same cells as QCPColorMapData::coordToCell, the first and last cell are centered on the range ends
+            const double timeCell = time / DENSITY_TIME_MAX * (DENSITY_TIME_CELLS - 1);
+            const double tempCell = (temp - DENSITY_TEMP_MIN) / (DENSITY_TEMP_MAX - DENSITY_TEMP_MIN) * (DENSITY_TEMP_CELLS - 1);
+            if (timeCell > -0.5 && timeCell < DENSITY_TIME_CELLS - 0.5 && tempCell > -0.5 && tempCell < DENSITY_TEMP_CELLS - 0.5)
+                counts[qRound(tempCell) * DENSITY_TIME_CELLS + qRound(timeCell)]++;
+        }
+        return counts;
+    }
+};
+
+/**
+ * Adds the histogram of one session to the running total.
+ * QtConcurrent calls this for one session at a time, as the sessions finish.
+ */
+static void addCounts(QVector<quint32> &total, const QVector<quint32> &counts)
+{
+    if (counts.isEmpty())
+        return;
+    if (total.isEmpty()) {
+        total = counts;
+        return;
+    }
+    quint32 *sum = total.data();
+    const quint32 *add = counts.constData();
+    for (int i = 0; i < total.size(); i++)
+        sum[i] += add[i];
+}
+
+
+/**
+ * Opens the window and starts counting the *-Game.csv files in \a directory in the background.
+ */
+SessionDensity::SessionDensity(const QString &directory, QWidget *parent) :
+    QMainWindow(parent)
+{
+    setAttribute(Qt::WA_DeleteOnClose);
+    setWindowTitle("Sessions in " + QDir(directory).absolutePath());
+    resize(800, 500);
+
+    this->plot = new QCustomPlot(this);
+    setCentralWidget(this->plot);
+    this->plot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+    this->plot->xAxis->setLabel("Time [min]");
+    this->plot->yAxis->setLabel("Temperature [C]");
+
+    this->density = new QCPColorMap(this->plot->xAxis, this->plot->yAxis);
+    this->density->data()->setSize(DENSITY_TIME_CELLS, DENSITY_TEMP_CELLS);
+    this->density->data()->setRange(QCPRange(0, DENSITY_TIME_MAX), QCPRange(DENSITY_TEMP_MIN, DENSITY_TEMP_MAX));
+    this->density->setGradient(QCPColorGradient::gpThermal);
+    this->density->setInterpolate(false);
+
+    // counts span several decades, on a log scale a few unusual runs stay visible next to the crowd
+    QCPColorScale *scale = new QCPColorScale(this->plot);
+    this->plot->plotLayout()->addElement(0, 1, scale);
+    scale->axis()->setLabel("Samples");
+    this->density->setColorScale(scale);
+    this->density->setDataScaleType(QCPAxis::stLogarithmic);
+    QCPMarginGroup *margins = new QCPMarginGroup(this->plot);
+    this->plot->axisRect()->setMarginGroup(QCP::msBottom | QCP::msTop, margins);
+    scale->setMarginGroup(QCP::msBottom | QCP::msTop, margins);
+    this->plot->rescaleAxes();
+
+    QStringList csvPaths;
+    for (const QFileInfo &info : QDir(directory).entryInfoList(QStringList() << "*-Game.csv", QDir::Files))
+        csvPaths << info.absoluteFilePath();
+    if (csvPaths.isEmpty()) {
+        statusBar()->showMessage("No session files found");
+        return;
+    }
+
+    statusBar()->showMessage(QString("Counting %1 sessions").arg(csvPaths.size()));
+    connect(&this->watcher, &QFutureWatcherBase::progressValueChanged, this, &SessionDensity::showProgress);
+    connect(&this->watcher, &QFutureWatcherBase::finished, this, &SessionDensity::showDensity);
+    this->watcher.setFuture(QtConcurrent::mappedReduced(csvPaths, CountSession(), addCounts, QtConcurrent::UnorderedReduce));
+}
+
+/**
+ * Stops counting if the window is closed before all sessions are done.
+ */
+SessionDensity::~SessionDensity()
+{
+    this->watcher.cancel();
+    this->watcher.waitForFinished();
+}
+
+void SessionDensity::showProgress(int sessions)
+{
+    statusBar()->showMessage(QString("Counted %1 of %2 sessions").arg(sessions).arg(this->watcher.progressMaximum()));
+}
+
+/**
+ * Called when all sessions are counted.
+ * Copies the counts into the color map, cells without any sample are left transparent.
+ */
+void SessionDensity::showDensity()
+{
+    if (this->watcher.isCanceled())
+        return;
+
+    const QVector<quint32> counts = this->watcher.result();
+    QCPColorMapData *data = this->density->data();
+    quint32 maxCount = 0;
+    for (int temp = 0; temp < DENSITY_TEMP_CELLS; temp++) {
+        for (int time = 0; time < DENSITY_TIME_CELLS; time++) {
+            const quint32 count = counts.isEmpty() ? 0 : counts[temp * DENSITY_TIME_CELLS + time];
+            data->setCell(time, temp, count);
+            data->setAlpha(time, temp, count > 0 ? 255 : 0);
+            maxCount = qMax(maxCount, count);
+        }
+    }
+    // the log scale needs a positive lower bound, empty cells are transparent anyway
+    this->density->setDataRange(QCPRange(1, qMax<quint32>(maxCount, 2)));
+    this->plot->replot();
+
+    statusBar()->showMessage(QString("%1 sessions, up to %2 samples per cell").arg(this->watcher.progressMaximum()).arg(maxCount));
+}
@@ -0,0 +1,60 @@
+/*
+Copyright (C) 2019  Anthony Arrowood
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SESSIONDENSITY_H
+#define SESSIONDENSITY_H
+
+#include <QMainWindow>
+#include <QFutureWatcher>
+#include <QVector>
+
+#define DENSITY_TIME_MAX     35.0   // minutes of a session covered by the density image
+#define DENSITY_TIME_CELLS   351    // 0.1 min per cell
+#define DENSITY_TEMP_MIN     15.0   // temperature range of the density image [C]
+#define DENSITY_TEMP_MAX     50.0
+#define DENSITY_TEMP_CELLS   351    // 0.1 C per cell
+
+class QCustomPlot;
+class QCPColorMap;
+
+/**
+ * Shows the temperature traces of many sessions at once, as a density image of time against
+ * temperature where each cell counts the samples of all sessions that fell into it.
+ *
+ * The session csv files are parsed in parallel, each into its own histogram, and the histograms
+ * are summed up as they finish. Only the sums end up in the color map, so drawing the image costs
+ * the same for ten sessions or ten thousand.
+ */
+class SessionDensity : public QMainWindow
+{
+    Q_OBJECT
+public:
+    explicit SessionDensity(const QString &directory, QWidget *parent = nullptr);
+    ~SessionDensity() override;
+
+private slots:
+    void showProgress(int sessions);
+    void showDensity();
+
+private:
+    QCustomPlot *plot;
+    QCPColorMap *density;
+    QFutureWatcher<QVector<quint32> > watcher;
+};
+
+#endif // SESSIONDENSITY_H
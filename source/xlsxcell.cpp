@@ -16,6 +16,7 @@
 #include "xlsxutility_p.h"
 #include "xlsxworksheet.h"
 #include "xlsxworkbook.h"
+#include "xlsxstyles_p.h"
 #include <cmath>
 #include <QDateTime>
 #include <QDate>
@@ -24,17 +25,106 @@
 QT_BEGIN_NAMESPACE_XLSX
 
 CellPrivate::CellPrivate(Cell *p) :
-	q_ptr(p)
+	valueType(VT_Invalid), cellType(Cell::NumberType), styleNumber(-1), parent(NULL), q_ptr(p)
 {
-
+	data.number = 0;
 }
 
 CellPrivate::CellPrivate(const CellPrivate * const cp)
-	: value(cp->value), formula(cp->formula), cellType(cp->cellType)
-	, format(cp->format), richString(cp->richString), parent(cp->parent),
-	styleNumber(cp->styleNumber)
+	: data(cp->data), valueType(cp->valueType), cellType(cp->cellType)
+	, styleNumber(cp->styleNumber), format(cp->format), parent(cp->parent), q_ptr(NULL)
+	, extra(cp->extra ? new ExtraData(*cp->extra) : NULL)
+{
+
+}
+
+/*
+ * Returns the value as a QVariant, for the public API only.
+ */
+QVariant CellPrivate::value() const
+{
+	switch (valueType) {
+	case VT_Double:
+		return QVariant(data.number);
+	case VT_Bool:
+		return QVariant(data.boolean);
+	case VT_String:
+		return QVariant(extra->string);
+	default:
+		return QVariant();
+	}
+}
+
+double CellPrivate::toDouble() const
+{
+	switch (valueType) {
+	case VT_Double:
+		return data.number;
+	case VT_Bool:
+		return data.boolean ? 1.0 : 0.0;
+	case VT_String:
+		return extra->string.toDouble();
+	default:
+		return 0.0;
+	}
+}
+
+void CellPrivate::setValue(const QVariant &value)
+{
+	switch (value.userType()) {
+	case QMetaType::UnknownType:
+		valueType = VT_Invalid;
+		break;
+	case QMetaType::Double:
+	case QMetaType::Float:
+	case QMetaType::Int:
+	case QMetaType::UInt:
+	case QMetaType::LongLong:
+	case QMetaType::ULongLong:
+		setValue(value.toDouble());
+		break;
+	case QMetaType::Bool:
+		setValue(value.toBool());
+		break;
+	default:
+		setValue(value.toString());
+		break;
+	}
+}
+
+void CellPrivate::setValue(double number)
 {
+	data.number = number;
+	valueType = VT_Double;
+}
+
+void CellPrivate::setValue(bool boolean)
+{
+	data.boolean = boolean;
+	valueType = VT_Bool;
+}
 
+void CellPrivate::setValue(const QString &string)
+{
+	extraData().string = string;
+	valueType = VT_String;
+}
+
+CellFormula CellPrivate::formula() const
+{
+	return extra ? extra->formula : CellFormula();
+}
+
+RichString CellPrivate::richString() const
+{
+	return extra ? extra->richString : RichString();
+}
+
+CellPrivate::ExtraData &CellPrivate::extraData()
+{
+	if (!extra)
+		extra.reset(new ExtraData);
+	return *extra;
 }
 
 /*!
@@ -66,13 +156,52 @@ Cell::Cell(const QVariant &data,
 	qint32 styleIndex ) :
 	d_ptr(new CellPrivate(this))
 {
-	d_ptr->value = data;
+	d_ptr->setValue(data);
 	d_ptr->cellType = type;
 	d_ptr->format = format;
 	d_ptr->parent = parent;
 	d_ptr->styleNumber = styleIndex; 
 }
 
+/*!
+ * \internal
+ * Created by Worksheet only. Stores \a data without going through QVariant.
+ */
+Cell::Cell(double data, CellType type, const Format &format, Worksheet *parent) :
+	d_ptr(new CellPrivate(this))
+{
+	d_ptr->setValue(data);
+	d_ptr->cellType = type;
+	d_ptr->format = format;
+	d_ptr->parent = parent;
+}
+
+/*!
+ * \internal
+ * \overload
+ */
+Cell::Cell(bool data, CellType type, const Format &format, Worksheet *parent) :
+	d_ptr(new CellPrivate(this))
+{
+	d_ptr->setValue(data);
+	d_ptr->cellType = type;
+	d_ptr->format = format;
+	d_ptr->parent = parent;
+}
+
+/*!
+ * \internal
+ * \overload
+ */
+Cell::Cell(const QString &data, CellType type, const Format &format, Worksheet *parent) :
+	d_ptr(new CellPrivate(this))
+{
+	d_ptr->setValue(data);
+	d_ptr->cellType = type;
+	d_ptr->format = format;
+	d_ptr->parent = parent;
+}
+
 /*!
  * \internal
  */
@@ -108,7 +237,7 @@ QVariant Cell::value() const
 {
 	Q_D(const Cell); 
 
-	return d->value; 
+	return d->value(); 
 }
 
 /*!
@@ -119,7 +248,7 @@ QVariant Cell::readValue() const
 	Q_D(const Cell);
 
 	QVariant ret; // return value 
-	ret = d->value;
+	ret = d->value();
 
 	Format fmt = this->format();
 	int noFormatIndex = fmt.numberFormatIndex(); 
@@ -154,7 +283,7 @@ QVariant Cell::readValue() const
 
 		if (styleNo == 13) // (HH:mm:ss) 
 		{
-			double dValue = d->value.toDouble(); 
+			double dValue = d->toDouble(); 
 			int day = int(dValue); // unit is day. 
 			double deciamlPointValue1 = dValue - double(day);
 
@@ -209,7 +338,7 @@ bool Cell::hasFormula() const
 {
 	Q_D(const Cell);
 
-	return d->formula.isValid();
+	return d->extra && d->extra->formula.isValid();
 }
 
 /*!
@@ -219,7 +348,7 @@ CellFormula Cell::formula() const
 {
 	Q_D(const Cell);
 
-	return d->formula;
+	return d->formula();
 }
 
 /*!
@@ -229,21 +358,17 @@ bool Cell::isDateTime() const
 {
 	Q_D(const Cell);
 
-	Cell::CellType cellType = d->cellType;
-	double dValue = d->value.toDouble();
-	QString strValue = d->value.toString().toUtf8(); 
-	bool isValidFormat = d->format.isValid();
-	bool isDateTimeFormat = d->format.isDateTimeFormat();
+	if (d->cellType != NumberType || !d->format.isValid())
+		return false;
+
+	if (d->toDouble() < 0)
+		return false;
 
-	if ( cellType == NumberType && 
-		 dValue >= 0 &&
-		 isValidFormat &&
-		 isDateTimeFormat )
-	{
-		return true;
-	}
+	//Number format classification is cached by the workbook styles
+	if (d->parent)
+		return d->parent->workbook()->styles()->isDateTimeFormat(d->format);
 
-	return false;
+	return d->format.isDateTimeFormat();
 }
 
 /*!
@@ -256,7 +381,7 @@ QDateTime Cell::dateTime() const
 	if (!isDateTime())
 		return QDateTime();
 
-	return datetimeFromNumber(d->value.toDouble(), d->parent->workbook()->isDate1904());
+	return datetimeFromNumber(d->toDouble(), d->parent->workbook()->isDate1904());
 }
 
 /*!
@@ -270,7 +395,7 @@ bool Cell::isRichString() const
 			&& d->cellType != StringType)
 		return false;
 
-	return d->richString.isRichString();
+	return d->extra && d->extra->richString.isRichString();
 }
 
 qint32 Cell::styleNumber() const 
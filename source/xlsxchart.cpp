@@ -138,6 +138,43 @@ void Chart::addSeries(const CellRange &range, AbstractSheet *sheet)
     }
 }
 
+/*!
+ * Add one data series whose values are in \a valRange and whose keys
+ * (x values of a scatter chart, categories otherwise) are in \a keyRange
+ * of the \a sheet. Both ranges must be a single row or column. If
+ * \a nameCell is valid, the series is named after the contents of that cell.
+ */
+void Chart::addSeries(const CellRange &keyRange, const CellRange &valRange, AbstractSheet *sheet, const CellReference &nameCell)
+{
+    Q_D(Chart);
+    if (!keyRange.isValid() || !valRange.isValid())
+        return;
+    if (sheet && sheet->sheetType() != AbstractSheet::ST_WorkSheet)
+        return;
+    if (!sheet && d->sheet->sheetType() != AbstractSheet::ST_WorkSheet)
+        return;
+
+    QString sheetName = sheet ? sheet->sheetName() : d->sheet->sheetName();
+    //In case sheetName contains space or '
+    sheetName = escapeSheetName(sheetName);
+
+    QSharedPointer<XlsxSeries> series = QSharedPointer<XlsxSeries>(new XlsxSeries);
+    series->axDataSource_numRef = sheetName + QLatin1String("!") + keyRange.toString(true, true);
+    series->numberDataSource_numRef = sheetName + QLatin1String("!") + valRange.toString(true, true);
+    if (nameCell.isValid())
+        series->seriesName_strRef = sheetName + QLatin1String("!") + nameCell.toString(true, true);
+    d->seriesList.append(series);
+}
+
+/*!
+ * Removes all data series from the chart.
+ */
+void Chart::clearSeries()
+{
+    Q_D(Chart);
+    d->seriesList.clear();
+}
+
 /*!
  * Set the type of the chart to \a type
  */
@@ -483,6 +520,7 @@ void ChartPrivate::saveXmlScatterChart(QXmlStreamWriter &writer) const
     writer.writeStartElement(name);
 
     writer.writeEmptyElement(QStringLiteral("c:scatterStyle"));
+    writer.writeAttribute(QStringLiteral("val"), QStringLiteral("lineMarker"));
 
     for (int i=0; i<seriesList.size(); ++i)
         saveXmlSer(writer, seriesList[i].data(), i);
@@ -559,6 +597,22 @@ void ChartPrivate::saveXmlSer(QXmlStreamWriter &writer, XlsxSeries *ser, int id)
     writer.writeEmptyElement(QStringLiteral("c:order"));
     writer.writeAttribute(QStringLiteral("val"), QString::number(id));
 
+    if (!ser->seriesName_strRef.isEmpty()) {
+        writer.writeStartElement(QStringLiteral("c:tx"));
+        writer.writeStartElement(QStringLiteral("c:strRef"));
+        writer.writeTextElement(QStringLiteral("c:f"), ser->seriesName_strRef);
+        writer.writeEndElement();//c:strRef
+        writer.writeEndElement();//c:tx
+    }
+
+    if (chartType == Chart::CT_Scatter) {
+        //Lines only, markers on long series make Excel crawl
+        writer.writeStartElement(QStringLiteral("c:marker"));
+        writer.writeEmptyElement(QStringLiteral("c:symbol"));
+        writer.writeAttribute(QStringLiteral("val"), QStringLiteral("none"));
+        writer.writeEndElement();//c:marker
+    }
+
     if (!ser->axDataSource_numRef.isEmpty()) {
         if (chartType == Chart::CT_Scatter || chartType == Chart::CT_Bubble)
             writer.writeStartElement(QStringLiteral("c:xVal"));
@@ -474,6 +474,32 @@ QVariant Document::read(int row, int col) const
 	return QVariant();
 }
 
+/*!
+	Copies the numeric contents of \a range of the current worksheet
+	into \a out. Returns the number of numeric cells found.
+
+	\sa Worksheet::readRange()
+ */
+int Document::readRange(const CellRange &range, double *out) const
+{
+	if (Worksheet *sheet = currentWorksheet())
+		return sheet->readRange(range, out);
+	return 0;
+}
+
+/*!
+	Copies the numeric contents of \a column from \a firstRow to \a lastRow
+	of the current worksheet into \a out. Returns the number of numeric cells found.
+
+	\sa Worksheet::readColumn()
+ */
+int Document::readColumn(int column, int firstRow, int lastRow, double *out) const
+{
+	if (Worksheet *sheet = currentWorksheet())
+		return sheet->readColumn(column, firstRow, lastRow, out);
+	return 0;
+}
+
 /*!
  * Insert an \a image to current active worksheet at the position \a row, \a column
  * Returns ture if success.
@@ -253,15 +253,23 @@ bool Format::isDateTimeFormat() const
 	else if (hasProperty(FormatPrivate::P_NumFmt_Id))
 	{
 		//Non-custom numFmt
-		int idx = numberFormatIndex();
+		return isBuiltinDateTimeFormat(numberFormatIndex());
+	}
 
-		//Is built-in date time number id?
-		if ((idx >= 14 && idx <= 22) || (idx >= 45 && idx <= 47))
-			return true;
+	return false;
+}
 
-		if ((idx >= 27 && idx <= 36) || (idx >= 50 && idx <= 58)) //Used in CHS\CHT\JPN\KOR
-			return true;
-	}
+/*!
+ * \internal
+ * Returns whether \a id is one of the built-in date time number format ids.
+ */
+bool Format::isBuiltinDateTimeFormat(int id)
+{
+	if ((id >= 14 && id <= 22) || (id >= 45 && id <= 47))
+		return true;
+
+	if ((id >= 27 && id <= 36) || (id >= 50 && id <= 58)) //Used in CHS\CHT\JPN\KOR
+		return true;
 
 	return false;
 }
@@ -15,6 +15,7 @@
 #include "xlsxformat_p.h"
 #include "xlsxutility_p.h"
 #include "xlsxcolor_p.h"
+#include "xlsxnumformatparser_p.h"
 #include <QXmlStreamWriter>
 #include <QXmlStreamReader>
 #include <QFile>
@@ -78,6 +79,28 @@ Format Styles::dxfFormat(int idx) const
     return m_dxf_formatsList[idx];
 }
 
+/*
+   Returns whether the number format of \a format is a date/time format.
+
+   Unlike Format::isDateTimeFormat(), which parses custom format strings
+   on each call, registered custom formats are looked up by their id and
+   use the classification computed when they were added.
+ */
+bool Styles::isDateTimeFormat(const Format &format) const
+{
+    if (!format.hasProperty(FormatPrivate::P_NumFmt_Id))
+        return format.isDateTimeFormat();
+
+    const int id = format.numberFormatIndex();
+    QMap<int, QSharedPointer<XlsxFormatNumberData> >::const_iterator it = m_customNumFmtIdMap.constFind(id);
+    if (it != m_customNumFmtIdMap.constEnd())
+        return it.value()->isDateTime;
+    if (id < 164) //Built-in number formats
+        return Format::isBuiltinDateTimeFormat(id);
+
+    return format.isDateTimeFormat();
+}
+
 void Styles::fixNumFmt(const Format &format)
 {
     if (!format.hasNumFmtData())
@@ -142,6 +165,7 @@ void Styles::fixNumFmt(const Format &format)
             QSharedPointer<XlsxFormatNumberData> fmt(new XlsxFormatNumberData);
             fmt->formatIndex = m_nextCustomNumFmtId;
             fmt->formatString = str;
+            fmt->isDateTime = NumFormatParser::isDateTime(str);
             m_customNumFmtIdMap.insert(m_nextCustomNumFmtId, fmt);
             m_customNumFmtsHash.insert(str, fmt);
 
@@ -708,6 +732,7 @@ bool Styles::readNumFmts(QXmlStreamReader &reader)
                 QSharedPointer<XlsxFormatNumberData> fmt (new XlsxFormatNumberData);
                 fmt->formatIndex = attributes.value(QLatin1String("numFmtId")).toString().toInt();
                 fmt->formatString = attributes.value(QLatin1String("formatCode")).toString();
+                fmt->isDateTime = NumFormatParser::isDateTime(fmt->formatString);
                 if (fmt->formatIndex >= m_nextCustomNumFmtId)
                     m_nextCustomNumFmtId = fmt->formatIndex + 1;
                 m_customNumFmtIdMap.insert(fmt->formatIndex, fmt);
@@ -92,24 +92,30 @@ double timeToNumber(const QTime &time)
     return QTime(0,0).msecsTo(time) / (1000*60*60*24.0);
 }
 
+//Julian day of the epoch used by the 1900 and the 1904 date systems.
+static constexpr qint64 excelEpochJulianDay[2] = { 2415020 /*1899-12-31*/, 2416481 /*1904-01-01*/ };
+static constexpr qint64 msecsPerDay = 1000*60*60*24;
+
+/*
+ * The serial number is split into a day count and the time of the day,
+ * and both are converted directly. The result is the local wall clock
+ * time Excel shows, no time zone arithmetic is done.
+ */
 QDateTime datetimeFromNumber(double num, bool is1904)
 {
     if (!is1904 && num > 60)
         num = num - 1;
 
-    qint64 msecs = static_cast<qint64>(num * 1000*60*60*24.0 + 0.5);
-    QDateTime epoch(is1904 ? QDate(1904, 1, 1): QDate(1899, 12, 31), QTime(0,0));
-
-    QDateTime dt = epoch.addMSecs(msecs);
-
-#if QT_VERSION >= 0x050200
-    // Remove one hour to see whether the date is Daylight
-    QDateTime dt2 = dt.addMSecs(-3600);
-    if (dt2.isDaylightTime())
-        return dt2;
-#endif
+    qint64 msecs = static_cast<qint64>(num * msecsPerDay + 0.5);
+    qint64 days = msecs / msecsPerDay;
+    qint64 msecsOfDay = msecs % msecsPerDay;
+    if (msecsOfDay < 0) {
+        days -= 1;
+        msecsOfDay += msecsPerDay;
+    }
 
-    return dt;
+    return QDateTime(QDate::fromJulianDay(excelEpochJulianDay[is1904 ? 1 : 0] + days),
+                     QTime::fromMSecsSinceStartOfDay(static_cast<int>(msecsOfDay)));
 }
 
 /*
@@ -24,8 +24,11 @@
 #include <QTextDocument>
 #include <QDir>
 #include <QMapIterator>
+#include <QtNumeric>
 
 #include <cmath>
+#include <algorithm>
+#include <iterator>
 
 #include "xlsxrichstring.h"
 #include "xlsxcellreference.h"
@@ -70,56 +73,26 @@ WorksheetPrivate::~WorksheetPrivate()
 }
 
 /*
-  Calculate the "spans" attribute of the <row> tag. This is an
-  XLSX optimisation and isn't strictly required. However, it
-  makes comparing files easier. The span is the same for each
-  block of 16 rows.
- */
-void WorksheetPrivate::calculateSpans() const
-{
-	row_spans.clear();
-	int span_min = XLSX_COLUMN_MAX+1;
-	int span_max = -1;
-
-	for (int row_num = dimension.firstRow(); row_num <= dimension.lastRow(); row_num++) {
-		if (cellTable.contains(row_num)) {
-			for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn(); col_num++) {
-				if (cellTable[row_num].contains(col_num)) {
-					if (span_max == -1) {
-						span_min = col_num;
-						span_max = col_num;
-					} else {
-						if (col_num < span_min)
-							span_min = col_num;
-						else if (col_num > span_max)
-							span_max = col_num;
-					}
-				}
-			}
-		}
-		if (comments.contains(row_num)) {
-			for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn(); col_num++) {
-				if (comments[row_num].contains(col_num)) {
-					if (span_max == -1) {
-						span_min = col_num;
-						span_max = col_num;
-					} else {
-						if (col_num < span_min)
-							span_min = col_num;
-						else if (col_num > span_max)
-							span_max = col_num;
-					}
-				}
-			}
-		}
+  Store \a cell at (\a row, \a col) and keep the "spans" attribute of
+  the <row> tag up to date. This is an XLSX optimisation and isn't
+  strictly required. However, it makes comparing files easier. The
+  span is the same for each block of 16 rows, so it is tracked here
+  on every write instead of being recomputed over the whole sheet
+  dimension at save time.
+ */
+void WorksheetPrivate::insertCell(int row, int col, const QSharedPointer<Cell> &cell)
+{
+	cellTable[row][col] = cell;
 
-		if (row_num%16 == 0 || row_num == dimension.lastRow()) {
-			if (span_max != -1) {
-				row_spans[row_num / 16] = QStringLiteral("%1:%2").arg(span_min).arg(span_max);
-				span_min = XLSX_COLUMN_MAX+1;
-				span_max = -1;
-			}
-		}
+	const int span_index = (row-1) / 16;
+	QMap<int, QPair<int, int> >::iterator it = row_spans.find(span_index);
+	if (it == row_spans.end()) {
+		row_spans.insert(span_index, qMakePair(col, col));
+	} else {
+		if (col < it->first)
+			it->first = col;
+		if (col > it->second)
+			it->second = col;
 	}
 }
 
@@ -202,9 +175,9 @@ Worksheet *Worksheet::copy(const QString &distName, int distId) const
 			cell->d_ptr->parent = sheet;
 
 			if (cell->cellType() == Cell::SharedStringType)
-				d->workbook->sharedStrings()->addSharedString(cell->d_ptr->richString);
+				d->workbook->sharedStrings()->addSharedString(cell->d_ptr->richString());
 
-			sheet_d->cellTable[row][col] = cell;
+			sheet_d->insertCell(row, col, cell);
 		}
 	}
 
@@ -527,7 +500,7 @@ QVariant Worksheet::read(int row, int column) const
 
 	if (cell->isDateTime()) {
 		double val = cell->value().toDouble();
-		QDateTime dt = cell->dateTime();
+		QDateTime dt = datetimeFromNumber(val, d->workbook->isDate1904());
 		if (val < 1)
 			return dt.time();
 		if (fmod(val, 1.0) <  1.0/(1000*60*60*24)) //integer
@@ -538,6 +511,55 @@ QVariant Worksheet::read(int row, int column) const
 	return cell->value();
 }
 
+/*!
+	Copies the numeric contents of \a range into the caller provided
+	buffer \a out, which must hold range.rowCount() * range.columnCount()
+	doubles. Values are stored row by row. Cells that are empty or hold
+	strings, booleans or errors are stored as NaN; formula cells store
+	their cached result and date/time cells their serial number.
+
+	Unlike read(), the cell storage is walked only once and no QVariant
+	conversion is done per cell, which makes this the preferred way of
+	extracting large blocks of numbers.
+
+	Returns the number of numeric cells copied.
+ */
+int Worksheet::readRange(const CellRange &range, double *out) const
+{
+	Q_D(const Worksheet);
+	if (!range.isValid() || !out)
+		return 0;
+
+	// a sheet has up to 1048576 * 16384 cells, more than an int can count
+	const qint64 columnCount = range.columnCount();
+	std::fill(out, out + range.rowCount() * columnCount, qQNaN());
+
+	int count = 0;
+	auto rowIt = d->cellTable.lowerBound(range.firstRow());
+	for (; rowIt != d->cellTable.constEnd() && rowIt.key() <= range.lastRow(); ++rowIt) {
+		double *rowOut = out + (rowIt.key() - range.firstRow()) * columnCount;
+		const QMap<int, QSharedPointer<Cell> > &row = rowIt.value();
+		auto colIt = row.lowerBound(range.firstColumn());
+		for (; colIt != row.constEnd() && colIt.key() <= range.lastColumn(); ++colIt) {
+			if (WorksheetPrivate::numericCellValue(colIt.value().data(), rowOut + (colIt.key() - range.firstColumn())))
+				++count;
+		}
+	}
+	return count;
+}
+
+/*!
+	Copies the numeric contents of \a column from \a firstRow to \a lastRow
+	into \a out, which must hold lastRow - firstRow + 1 doubles. This is
+	readRange() for a single column.
+
+	Returns the number of numeric cells copied.
+ */
+int Worksheet::readColumn(int column, int firstRow, int lastRow, double *out) const
+{
+	return readRange(CellRange(firstRow, column, lastRow, column), out);
+}
+
 /*!
  * Returns the cell at the given \a row_column. If there
  * is no cell at the specified position, the function returns 0.
@@ -610,8 +632,8 @@ bool Worksheet::writeString(int row, int column, const RichString &value, const
 		fmt.mergeFormat(value.fragmentFormat(0));
 	d->workbook->styles()->addXfFormat(fmt);
 	QSharedPointer<Cell> cell = QSharedPointer<Cell>(new Cell(value.toPlainString(), Cell::SharedStringType, fmt, this));
-	cell->d_ptr->richString = value;
-	d->cellTable[row][column] = cell;
+	cell->d_ptr->extraData().richString = value;
+	d->insertCell(row, column, cell);
 	return true;
 }
 
@@ -679,7 +701,7 @@ bool Worksheet::writeInlineString(int row, int column, const QString &value, con
 
 	Format fmt = format.isValid() ? format : d->cellFormat(row, column);
 	d->workbook->styles()->addXfFormat(fmt);
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::InlineStringType, fmt, this));
+	d->insertCell(row, column, QSharedPointer<Cell>(new Cell(value, Cell::InlineStringType, fmt, this)));
 	return true;
 }
 
@@ -708,7 +730,7 @@ bool Worksheet::writeNumeric(int row, int column, double value, const Format &fo
 
 	Format fmt = format.isValid() ? format : d->cellFormat(row, column);
 	d->workbook->styles()->addXfFormat(fmt);
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::NumberType, fmt, this));
+	d->insertCell(row, column, QSharedPointer<Cell>(new Cell(value, Cell::NumberType, fmt, this)));
 	return true;
 }
 
@@ -750,8 +772,8 @@ bool Worksheet::writeFormula(int row, int column, const CellFormula &formula_, c
 	}
 
 	QSharedPointer<Cell> data = QSharedPointer<Cell>(new Cell(result, Cell::NumberType, fmt, this));
-	data->d_ptr->formula = formula;
-	d->cellTable[row][column] = data;
+	data->d_ptr->extraData().formula = formula;
+	d->insertCell(row, column, data);
 
 	CellRange range = formula.reference();
 	if (formula.formulaType() == CellFormula::SharedType) {
@@ -761,11 +783,11 @@ bool Worksheet::writeFormula(int row, int column, const CellFormula &formula_, c
 			for (int c=range.firstColumn(); c<=range.lastColumn(); ++c) {
 				if (!(r==row && c==column)) {
 					if(Cell *cell = cellAt(r, c)) {
-						cell->d_ptr->formula = sf;
+						cell->d_ptr->extraData().formula = sf;
 					} else {
 						QSharedPointer<Cell> newCell = QSharedPointer<Cell>(new Cell(result, Cell::NumberType, fmt, this));
-						newCell->d_ptr->formula = sf;
-						d->cellTable[r][c] = newCell;
+						newCell->d_ptr->extraData().formula = sf;
+						d->insertCell(r, c, newCell);
 					}
 				}
 			}
@@ -804,7 +826,7 @@ bool Worksheet::writeBlank(int row, int column, const Format &format)
 	d->workbook->styles()->addXfFormat(fmt);
 
 	//Note: NumberType with an invalid QVariant value means blank.
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(QVariant(), Cell::NumberType, fmt, this));
+	d->insertCell(row, column, QSharedPointer<Cell>(new Cell(QVariant(), Cell::NumberType, fmt, this)));
 
 	return true;
 }
@@ -833,7 +855,7 @@ bool Worksheet::writeBool(int row, int column, bool value, const Format &format)
 
 	Format fmt = format.isValid() ? format : d->cellFormat(row, column);
 	d->workbook->styles()->addXfFormat(fmt);
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::BooleanType, fmt, this));
+	d->insertCell(row, column, QSharedPointer<Cell>(new Cell(value, Cell::BooleanType, fmt, this)));
 
 	return true;
 }
@@ -867,7 +889,7 @@ bool Worksheet::writeDateTime(int row, int column, const QDateTime &dt, const Fo
 
 	double value = datetimeToNumber(dt, d->workbook->isDate1904());
 
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::NumberType, fmt, this));
+	d->insertCell(row, column, QSharedPointer<Cell>(new Cell(value, Cell::NumberType, fmt, this)));
 
 	return true;
 }
@@ -900,7 +922,7 @@ bool Worksheet::writeTime(int row, int column, const QTime &t, const Format &for
 		fmt.setNumberFormat(QStringLiteral("hh:mm:ss"));
 	d->workbook->styles()->addXfFormat(fmt);
 
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(timeToNumber(t), Cell::NumberType, fmt, this));
+	d->insertCell(row, column, QSharedPointer<Cell>(new Cell(timeToNumber(t), Cell::NumberType, fmt, this)));
 
 	return true;
 }
@@ -965,7 +987,7 @@ bool Worksheet::writeHyperlink(int row, int column, const QUrl &url, const Forma
 
 	//Write the hyperlink string as normal string.
 	d->sharedStrings()->addSharedString(displayString);
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(displayString, Cell::SharedStringType, fmt, this));
+	d->insertCell(row, column, QSharedPointer<Cell>(new Cell(displayString, Cell::SharedStringType, fmt, this)));
 
 	//Store the hyperlink data in a separate table
 	d->urlTable[row][column] = QSharedPointer<XlsxHyperlinkData>(new XlsxHyperlinkData(XlsxHyperlinkData::External, urlString, locationString, QString(), tip));
@@ -1311,17 +1333,26 @@ bool Worksheet::setStartPage(int spagen)
 
 void WorksheetPrivate::saveXmlSheetData(QXmlStreamWriter &writer) const
 {
-	calculateSpans();
-	for (int row_num = dimension.firstRow(); row_num <= dimension.lastRow(); row_num++) {
-		if (!(cellTable.contains(row_num) || comments.contains(row_num) || rowsInfo.contains(row_num))) {
-			//Only process rows with cell data / comments / formatting
+	//Only process rows with cell data / comments / formatting
+	QList<int> rows = cellTable.keys();
+	if (!comments.isEmpty() || !rowsInfo.isEmpty()) {
+		QList<int> infoRows;
+		std::set_union(comments.keyBegin(), comments.keyEnd(), rowsInfo.keyBegin(), rowsInfo.keyEnd(),
+					   std::back_inserter(infoRows));
+		QList<int> allRows;
+		std::set_union(rows.constBegin(), rows.constEnd(), infoRows.constBegin(), infoRows.constEnd(),
+					   std::back_inserter(allRows));
+		rows = allRows;
+	}
+
+	for (int row_num : qAsConst(rows)) {
+		if (row_num < dimension.firstRow() || row_num > dimension.lastRow())
 			continue;
-		}
 
-		int span_index = (row_num-1) / 16;
 		QString span;
-		if (row_spans.contains(span_index))
-			span = row_spans[span_index];
+		QMap<int, QPair<int, int> >::const_iterator spanIt = row_spans.constFind((row_num-1) / 16);
+		if (spanIt != row_spans.constEnd())
+			span = QStringLiteral("%1:%2").arg(spanIt->first).arg(spanIt->second);
 
 		writer.writeStartElement(QStringLiteral("row"));
 		writer.writeAttribute(QStringLiteral("r"), QString::number(row_num));
@@ -1353,12 +1384,10 @@ void WorksheetPrivate::saveXmlSheetData(QXmlStreamWriter &writer) const
 		}
 
 		//Write cell data if row contains filled cells
-		if (cellTable.contains(row_num)) {
-			for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn(); col_num++) {
-				if (cellTable[row_num].contains(col_num)) {
-					saveXmlCellData(writer, row_num, col_num, cellTable[row_num][col_num]);
-				}
-			}
+		QMap<int, QMap<int, QSharedPointer<Cell> > >::const_iterator rowIt = cellTable.constFind(row_num);
+		if (rowIt != cellTable.constEnd()) {
+			for (QMap<int, QSharedPointer<Cell> >::const_iterator colIt = rowIt->constBegin(); colIt != rowIt->constEnd(); ++colIt)
+				saveXmlCellData(writer, row_num, colIt.key(), colIt.value());
 		}
 		writer.writeEndElement(); //row
 	}
@@ -1383,7 +1412,7 @@ void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer, int row, int co
 	if (cell->cellType() == Cell::SharedStringType) {
 		int sst_idx;
 		if (cell->isRichString())
-			sst_idx = sharedStrings()->getSharedStringIndex(cell->d_ptr->richString);
+			sst_idx = sharedStrings()->getSharedStringIndex(cell->d_ptr->richString());
 		else
 			sst_idx = sharedStrings()->getSharedStringIndex(cell->value().toString());
 
@@ -1394,7 +1423,7 @@ void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer, int row, int co
 		writer.writeStartElement(QStringLiteral("is"));
 		if (cell->isRichString()) {
 			//Rich text string
-			RichString string = cell->d_ptr->richString;
+			RichString string = cell->d_ptr->richString();
 			for (int i=0; i<string.fragmentCount(); ++i) {
 				writer.writeStartElement(QStringLiteral("r"));
 				if (string.fragmentFormat(i).hasFontData()) {
@@ -1421,8 +1450,8 @@ void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer, int row, int co
 	} else if (cell->cellType() == Cell::NumberType){
 		if (cell->hasFormula())
 			cell->formula().saveToXml(writer);
-		if (cell->value().isValid()) {//note that, invalid value means 'v' is blank
-			double value = cell->value().toDouble();
+		if (cell->d_ptr->isValid()) {//note that, invalid value means 'v' is blank
+			double value = cell->d_ptr->toDouble();
 			writer.writeTextElement(QStringLiteral("v"), QString::number(value, 'g', 15));
 		}
 	} else if (cell->cellType() == Cell::StringType) {
@@ -2075,7 +2104,7 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 					{
 						if (reader.name() == QLatin1String("f")) 
 						{
-							CellFormula &formula = cell->d_func()->formula;
+							CellFormula &formula = cell->d_func()->extraData().formula;
 							formula.loadFromXml(reader);
 							if (formula.formulaType() == CellFormula::SharedType && !formula.formulaText().isEmpty()) 
 							{
@@ -2093,28 +2122,28 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 								sharedStrings()->incRefByStringIndex(sst_idx);
 								RichString rs = sharedStrings()->getSharedString(sst_idx);
 								QString strPlainString = rs.toPlainString();
-								cell->d_func()->value = strPlainString; 
+								cell->d_func()->setValue(strPlainString);
 								if (rs.isRichString())
-									cell->d_func()->richString = rs;
+									cell->d_func()->extraData().richString = rs;
 							} 
 							else if (cellType == Cell::NumberType) 
 							{
-								cell->d_func()->value = value.toDouble();
+								cell->d_func()->setValue(value.toDouble());
 							} 
 							else if (cellType == Cell::BooleanType) 
 							{
-								cell->d_func()->value = value.toInt() ? true : false;
+								cell->d_func()->setValue(value.toInt() ? true : false);
 							} 
 							else 
 							{ //Cell::ErrorType and Cell::StringType
-								cell->d_func()->value = value;
+								cell->d_func()->setValue(value);
 							} 
 						} else if (reader.name() == QLatin1String("is")) {
 							while (!reader.atEnd() && !(reader.name() == QLatin1String("is") && reader.tokenType() == QXmlStreamReader::EndElement)) {
 								if (reader.readNextStartElement()) {
 									//:Todo, add rich text read support
 									if (reader.name() == QLatin1String("t")) {
-										cell->d_func()->value = reader.readElementText();
+										cell->d_func()->setValue(reader.readElementText());
 									}
 								}
 							}
@@ -2128,7 +2157,7 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 					}
 				}
 
-				cellTable[pos.row()][pos.column()] = cell;
+				insertCell(pos.row(), pos.column(), cell);
 			}
 		}
 	}
@@ -2472,6 +2501,20 @@ void WorksheetPrivate::validateDimension()
 		dimension = cr;
 }
 
+/*
+  Stores the numeric value of \a cell in \a value. Blank cells and cells
+  that do not hold a number leave \a value untouched and return false.
+ */
+bool WorksheetPrivate::numericCellValue(const Cell *cell, double *value)
+{
+	const CellPrivate *cd = cell->d_ptr;
+	if (cd->cellType != Cell::NumberType || cd->valueType != CellPrivate::VT_Double)
+		return false;
+
+	*value = cd->data.number;
+	return true;
+}
+
 /*!
  * \internal
  *  Unit test can use this member to get sharedString object.
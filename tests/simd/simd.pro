@@ -0,0 +1,43 @@
+# Copyright (C) 2019  Anthony Arrowood
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#-------------------------------------------------
+#
+# Checks that the vectorized QCustomPlot kernels of every CPU level give
+# exactly the results of the scalar code
+#
+#-------------------------------------------------
+
+QT       += core gui widgets printsupport testlib
+
+TARGET = tst_simd
+TEMPLATE = app
+CONFIG += console testcase \
+c+=11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../..
+
+# tst_simd.cpp includes qcustomplot.cpp to reach its internal kernels,
+# the header is listed so that moc runs on it
+SOURCES += \
+        tst_simd.cpp
+
+HEADERS += \
+        ../../qcustomplot.h
@@ -0,0 +1,314 @@
+/*
+Copyright (C) 2019  Anthony Arrowood
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QtTest>
+#include <cstring>
+#include <limits>
+#include <random>
+
+// the kernels are static functions of qcustomplot.cpp, so it is compiled as part of this test
+#include "qcustomplot.cpp"
+
+#define TEST_COUNT 1003   // not a multiple of any vector width, so the scalar tails are covered too
+
+/**
+ * Runs the kernels of one QCPSimd level directly, independent of the level picked by QCPSimd::level().
+ */
+static void mapPairsAt(int level, const double *in0, const double *in1, int inStride, int count,
+                       const QCPSimd::LinearMap &map0, const QCPSimd::LinearMap &map1, double *out)
+{
+#ifdef QCP_SIMD_X86
+    if (level == QCPSimd::lvAvx) {
+        QCPSimd::mapPairsAvx(in0, in1, inStride, count, map0, map1, out);
+        return;
+    }
+    if (level == QCPSimd::lvSse2) {
+        QCPSimd::mapPairsSse2(in0, in1, inStride, count, map0, map1, out);
+        return;
+    }
+#endif
+    QCPSimd::mapPairsScalar(in0, in1, inStride, count, map0, map1, out);
+}
+
+static void valueSpanAt(int level, const double *values, int stride, int count, double &minValue, double &maxValue)
+{
+#ifdef QCP_SIMD_X86
+    if (level == QCPSimd::lvAvx) {
+        QCPSimd::valueSpanAvx(values, stride, count, minValue, maxValue);
+        return;
+    }
+    if (level == QCPSimd::lvSse2) {
+        QCPSimd::valueSpanSse2(values, stride, count, minValue, maxValue);
+        return;
+    }
+#endif
+    QCPSimd::valueSpanScalar(values, stride, count, minValue, maxValue);
+}
+
+static void colorizeLinearAt(int level, const double *data, int stride, int count, double lower, double posToIndexFactor,
+                             const QRgb *colors, int levelCount, QRgb *out)
+{
+#ifdef QCP_SIMD_X86
+    if (level == QCPSimd::lvAvx) {
+        QCPSimd::colorizeLinearAvx(data, stride, count, lower, posToIndexFactor, colors, levelCount, out);
+        return;
+    }
+    if (level == QCPSimd::lvSse2) {
+        QCPSimd::colorizeLinearSse2(data, stride, count, lower, posToIndexFactor, colors, levelCount, out);
+        return;
+    }
+#endif
+    QCPSimd::colorizeLinearScalar(data, stride, count, lower, posToIndexFactor, colors, levelCount, out);
+}
+
+/**
+ * Returns \a count coordinates around the range 0..100, starting with the values that need
+ * special care: NaN, infinities, signed zeros, huge and denormal numbers.
+ */
+static QVector<double> testValues(int count, unsigned seed)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    QVector<double> values;
+    values << qQNaN() << inf << -inf << 0.0 << -0.0 << 100.0 << 1e300 << -1e300
+           << std::numeric_limits<double>::denorm_min() << 50.0 << qQNaN();
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> around(-50, 150);
+    while (values.size() < count)
+        values << around(random);
+    return values;
+}
+
+static bool sameBits(double a, double b)
+{
+    if (qIsNaN(a) || qIsNaN(b))
+        return qIsNaN(a) && qIsNaN(b);
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static bool sameSpan(double a, double b)
+{
+    // signed zeros may end up in another lane, so -0 and 0 are treated as the same span bound
+    if (qIsNaN(a) || qIsNaN(b))
+        return qIsNaN(a) && qIsNaN(b);
+    return a == b;
+}
+
+/**
+ * The color table index of \a value as documented for QCPSimd::colorizeLinear.
+ */
+static int referenceIndex(double value, double lower, double posToIndexFactor, int levelCount)
+{
+    const double index = (value - lower) * posToIndexFactor;
+    if (qIsNaN(index) || index <= 0)
+        return 0;
+    if (index >= levelCount - 1)
+        return levelCount - 1;
+    return static_cast<int>(index);
+}
+
+
+/**
+ * Checks that the SSE2 and AVX kernels of QCPSimd give exactly the results of the scalar
+ * kernels and of the code they replace. Each test runs once per level the CPU supports,
+ * limited like the plot itself by the QCP_SIMD environment variable.
+ */
+class TestSimd : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void mapPairs_data();
+    void mapPairs();
+    void valueSpan_data();
+    void valueSpan();
+    void colorizeLinear_data();
+    void colorizeLinear();
+
+private:
+    void addLevels();
+
+    QCustomPlot *plot;
+};
+
+void TestSimd::initTestCase()
+{
+    this->plot = new QCustomPlot;
+    this->plot->setViewport(QRect(0, 0, 640, 480));
+    this->plot->replot();  // lays out the axis rect, which the pixel transforms depend on
+    QVERIFY(this->plot->axisRect()->width() > 0 && this->plot->axisRect()->height() > 0);
+}
+
+void TestSimd::cleanupTestCase()
+{
+    delete this->plot;
+}
+
+void TestSimd::addLevels()
+{
+    QTest::addColumn<int>("level");
+    QTest::newRow("scalar") << static_cast<int>(QCPSimd::lvScalar);
+    if (QCPSimd::level() >= QCPSimd::lvSse2)
+        QTest::newRow("sse2") << static_cast<int>(QCPSimd::lvSse2);
+    if (QCPSimd::level() >= QCPSimd::lvAvx)
+        QTest::newRow("avx") << static_cast<int>(QCPSimd::lvAvx);
+}
+
+void TestSimd::mapPairs_data()
+{
+    addLevels();
+}
+
+/**
+ * Compares the pixel pairs of mapPairs with QCPAxis::coordToPixel for both key axis orientations,
+ * all combinations of reversed ranges and interleaved pairs in either order.
+ */
+void TestSimd::mapPairs()
+{
+    QFETCH(int, level);
+
+    const QVector<double> keys = testValues(TEST_COUNT, 1);
+    const QVector<double> values = testValues(TEST_COUNT, 2);
+    QVector<double> pairs(2 * TEST_COUNT);  // key, value, key, value, ... like QCPGraphData
+    for (int i = 0; i < TEST_COUNT; i++) {
+        pairs[2 * i] = keys[i];
+        pairs[2 * i + 1] = values[i];
+    }
+    QVector<double> out(2 * TEST_COUNT);
+
+    for (int config = 0; config < 8; config++) {
+        const bool verticalKey = config & 1;
+        QCPAxis *keyAxis = verticalKey ? this->plot->yAxis : this->plot->xAxis;
+        QCPAxis *valueAxis = verticalKey ? this->plot->xAxis : this->plot->yAxis;
+        keyAxis->setRange(-3, 97);
+        valueAxis->setRange(10, 20.5);
+        keyAxis->setRangeReversed(config & 2);
+        valueAxis->setRangeReversed(config & 4);
+        QCPSimd::LinearMap keyMap, valueMap;
+        QVERIFY(QCPSimd::linearMap(keyAxis, keyMap));
+        QVERIFY(QCPSimd::linearMap(valueAxis, valueMap));
+
+        for (int layout = 0; layout < 2; layout++) {
+            if (layout == 0)  // key first
+                mapPairsAt(level, pairs.constData(), pairs.constData() + 1, 2, TEST_COUNT, keyMap, valueMap, out.data());
+            else              // value first, like drawing with a vertical key axis
+                mapPairsAt(level, pairs.constData() + 1, pairs.constData(), 2, TEST_COUNT, valueMap, keyMap, out.data());
+
+            for (int i = 0; i < TEST_COUNT; i++) {
+                const double keyPixel = keyAxis->coordToPixel(keys[i]);
+                const double valuePixel = valueAxis->coordToPixel(values[i]);
+                const double first = layout == 1 ? valuePixel : keyPixel;
+                const double second = layout == 1 ? keyPixel : valuePixel;
+                QVERIFY2(sameBits(out[2 * i], first) && sameBits(out[2 * i + 1], second),
+                         qPrintable(QString("config %1, layout %2, point %3: (%4, %5) instead of (%6, %7)")
+                                    .arg(config).arg(layout).arg(i)
+                                    .arg(out[2 * i], 0, 'g', 17).arg(out[2 * i + 1], 0, 'g', 17)
+                                    .arg(first, 0, 'g', 17).arg(second, 0, 'g', 17)));
+            }
+        }
+    }
+    this->plot->xAxis->setRangeReversed(false);
+    this->plot->yAxis->setRangeReversed(false);
+}
+
+void TestSimd::valueSpan_data()
+{
+    addLevels();
+}
+
+/**
+ * Compares the span of valueSpan with the scalar span for strides 1 and 2, all run lengths up to
+ * a few vector widths and starting bounds that are infinite, finite or NaN.
+ */
+void TestSimd::valueSpan()
+{
+    QFETCH(int, level);
+
+    const double inf = std::numeric_limits<double>::infinity();
+    const QVector<double> values = testValues(2 * TEST_COUNT, 3);
+    QVector<double> withoutSpecials = values.mid(11);  // only finite values, so the span is finite too
+
+    for (int stride = 1; stride <= 2; stride++) {
+        for (int special = 0; special < 2; special++) {
+            const double *data = special ? values.constData() : withoutSpecials.constData();
+            const int available = (special ? values.size() : withoutSpecials.size()) / stride;
+            for (int count = 0; count <= available; count = count < 20 ? count + 1 : count * 2 + 1) {
+                const double starts[][2] = { { inf, -inf }, { 40, 60 }, { qQNaN(), qQNaN() } };
+                for (const auto &start : starts) {
+                    double scalarMin = start[0], scalarMax = start[1];
+                    QCPSimd::valueSpanScalar(data, stride, count, scalarMin, scalarMax);
+                    double min = start[0], max = start[1];
+                    valueSpanAt(level, data, stride, count, min, max);
+                    QVERIFY2(sameSpan(min, scalarMin) && sameSpan(max, scalarMax),
+                             qPrintable(QString("stride %1, count %2, start %3: (%4, %5) instead of (%6, %7)")
+                                        .arg(stride).arg(count).arg(start[0])
+                                        .arg(min).arg(max).arg(scalarMin).arg(scalarMax)));
+                }
+            }
+        }
+    }
+
+    // NaN values are skipped, a NaN start stays NaN
+    double min = inf, max = -inf;
+    valueSpanAt(level, values.constData(), 1, values.size(), min, max);
+    QCOMPARE(min, -inf);
+    QCOMPARE(max, inf);
+    min = qQNaN();
+    max = qQNaN();
+    valueSpanAt(level, withoutSpecials.constData(), 1, withoutSpecials.size(), min, max);
+    QVERIFY(qIsNaN(min) && qIsNaN(max));
+}
+
+void TestSimd::colorizeLinear_data()
+{
+    addLevels();
+}
+
+/**
+ * Compares the colors of colorizeLinear with the documented index computation, for strides 1 and
+ * 3 (a column of a color map) and a table of 350 colors like the default QCPColorGradient.
+ */
+void TestSimd::colorizeLinear()
+{
+    QFETCH(int, level);
+
+    const int levelCount = 350;
+    QVector<QRgb> colors(levelCount);
+    for (int i = 0; i < levelCount; i++)
+        colors[i] = 0xFF000000u | static_cast<QRgb>(i * 7919);
+
+    const QVector<double> values = testValues(3 * TEST_COUNT, 4);
+    const double lower = 1;
+    const double posToIndexFactor = (levelCount - 1) / 98.5;
+    QVector<QRgb> out(TEST_COUNT);
+    for (int stride = 1; stride <= 3; stride += 2) {
+        colorizeLinearAt(level, values.constData(), stride, TEST_COUNT, lower, posToIndexFactor,
+                         colors.constData(), levelCount, out.data());
+        for (int i = 0; i < TEST_COUNT; i++) {
+            const double value = values[i * stride];
+            const QRgb expected = colors[referenceIndex(value, lower, posToIndexFactor, levelCount)];
+            QVERIFY2(out[i] == expected,
+                     qPrintable(QString("stride %1, value %2: color %3 instead of %4")
+                                .arg(stride).arg(value, 0, 'g', 17).arg(out[i], 0, 16).arg(expected, 0, 16)));
+        }
+    }
+}
+
+QTEST_MAIN(TestSimd)
+#include "tst_simd.moc"